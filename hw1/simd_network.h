@@ -0,0 +1,161 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/// битоническая сортирующая сеть на 16 элементов для листьев mysort на арифметических ключах.
+/// для 32-битных типов при AVX2 все 16 элементов лежат в двух регистрах, и каждый шаг сети -
+/// перестановка, min, max и смешивание (float сортируются как int32 ключи того же порядка). скалярный
+/// вариант медленнее insertionSort, поэтому mysort использует сеть, только если SimdNetworkSupported<V>::value
+
+const std::ptrdiff_t networkSortSize = 16;
+
+template <typename V>
+struct SimdNetworkSupported : std::false_type {};
+
+/// элементы меняются местами, только если они строго не упорядочены, как в compareExchange из
+/// sorting_network.h: min/max при равных значениях вернули бы одно из них дважды (-0.0 и +0.0)
+template <typename V>
+void bitonicSort16Scalar(V* a) {
+    for (int k = 2; k <= 16; k *= 2) {
+        for (int j = k / 2; j > 0; j /= 2) {
+            for (int i = 0; i < 16; ++i) {
+                int partner = i ^ j;
+                if (partner > i) {
+                    bool ascending = (i & k) == 0;
+                    if (ascending ? a[partner] < a[i] : a[i] < a[partner]) {
+                        std::swap(a[i], a[partner]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+#if defined(__AVX2__)
+
+template <typename V>
+struct Avx2MinMax;
+
+template <>
+struct Avx2MinMax<std::int32_t> {
+    static __m256i min(__m256i a, __m256i b) { return _mm256_min_epi32(a, b); }
+    static __m256i max(__m256i a, __m256i b) { return _mm256_max_epi32(a, b); }
+};
+
+template <>
+struct Avx2MinMax<std::uint32_t> {
+    static __m256i min(__m256i a, __m256i b) { return _mm256_min_epu32(a, b); }
+    static __m256i max(__m256i a, __m256i b) { return _mm256_max_epu32(a, b); }
+};
+
+/// линия g (номер элемента среди 16) на шаге (K, J) берет минимум из пары, если направление
+/// ее битонической последовательности совпадает с тем, что она нижний элемент пары
+constexpr int bitonicTakesMin(int g, int k, int j) {
+    return (((g & k) == 0) == ((g & j) == 0)) ? -1 : 0;
+}
+
+/// шаг сети внутри одного регистра: пара линии i - линия i ^ J
+template <typename V, int K, int J, int Base>
+__m256i bitonicStep(__m256i r) {
+    __m256i partner = _mm256_permutevar8x32_epi32(r, _mm256_setr_epi32(0 ^ J, 1 ^ J, 2 ^ J, 3 ^ J,
+                                                                      4 ^ J, 5 ^ J, 6 ^ J, 7 ^ J));
+    __m256i lo = Avx2MinMax<V>::min(r, partner);
+    __m256i hi = Avx2MinMax<V>::max(r, partner);
+    __m256i takeMin = _mm256_setr_epi32(bitonicTakesMin(Base + 0, K, J), bitonicTakesMin(Base + 1, K, J),
+                                        bitonicTakesMin(Base + 2, K, J), bitonicTakesMin(Base + 3, K, J),
+                                        bitonicTakesMin(Base + 4, K, J), bitonicTakesMin(Base + 5, K, J),
+                                        bitonicTakesMin(Base + 6, K, J), bitonicTakesMin(Base + 7, K, J));
+    return _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(hi), _mm256_castsi256_ps(lo),
+                                                _mm256_castsi256_ps(takeMin)));
+}
+
+template <typename V, int K, int J>
+void bitonicStep2(__m256i& r0, __m256i& r1) {
+    r0 = bitonicStep<V, K, J, 0>(r0);
+    r1 = bitonicStep<V, K, J, 8>(r1);
+}
+
+template <typename V>
+void bitonicNetwork16(__m256i& r0, __m256i& r1) {
+    bitonicStep2<V, 2, 1>(r0, r1);
+    bitonicStep2<V, 4, 2>(r0, r1);
+    bitonicStep2<V, 4, 1>(r0, r1);
+    bitonicStep2<V, 8, 4>(r0, r1);
+    bitonicStep2<V, 8, 2>(r0, r1);
+    bitonicStep2<V, 8, 1>(r0, r1);
+
+    // J = 8: пары лежат в разных регистрах, а на последнем слиянии все направления возрастающие
+    __m256i lo = Avx2MinMax<V>::min(r0, r1);
+    __m256i hi = Avx2MinMax<V>::max(r0, r1);
+    r0 = lo;
+    r1 = hi;
+    bitonicStep2<V, 16, 4>(r0, r1);
+    bitonicStep2<V, 16, 2>(r0, r1);
+    bitonicStep2<V, 16, 1>(r0, r1);
+}
+
+template <typename V>
+void bitonicSort16Simd(V* a) {
+    __m256i r0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a));
+    __m256i r1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + 8));
+    bitonicNetwork16<V>(r0, r1);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(a), r0);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(a + 8), r1);
+}
+
+template <> struct SimdNetworkSupported<std::int32_t> : std::true_type {};
+template <> struct SimdNetworkSupported<std::uint32_t> : std::true_type {};
+template <> struct SimdNetworkSupported<float> : std::true_type {};
+
+inline void bitonicSort16(std::int32_t* a) {
+    bitonicSort16Simd(a);
+}
+
+inline void bitonicSort16(std::uint32_t* a) {
+    bitonicSort16Simd(a);
+}
+
+/// биты float как int32 с инвертированными битами значения у отрицательных чисел: порядок ключей совпадает
+/// с порядком чисел, и -0.0 < +0.0. преобразование обратно самому себе
+inline __m256i floatOrderedKeys(__m256i bits) {
+    return _mm256_xor_si256(bits, _mm256_srli_epi32(_mm256_srai_epi32(bits, 31), 1));
+}
+
+/// min_ps/max_ps при равных аргументах возвращают второй из них, и пара -0.0, +0.0 превратилась бы
+/// в два одинаковых нуля. поэтому сеть сортирует целые ключи, а не сами числа
+inline void bitonicSort16(float* a) {
+    __m256i r0 = floatOrderedKeys(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a)));
+    __m256i r1 = floatOrderedKeys(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + 8)));
+    bitonicNetwork16<std::int32_t>(r0, r1);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(a), floatOrderedKeys(r0));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(a + 8), floatOrderedKeys(r1));
+}
+
+#endif
+
+template <typename V>
+void bitonicSort16(V* a) {
+    bitonicSort16Scalar(a);
+}
+
+/// сортирует n <= 16 элементов: недостающие до 16 заполняются максимальным значением типа
+template <typename V>
+void networkSort(V* first, std::ptrdiff_t n) {
+    const V padding = std::numeric_limits<V>::has_infinity ? std::numeric_limits<V>::infinity()
+                                                            : std::numeric_limits<V>::max();
+    V buffer[networkSortSize];
+    for (std::ptrdiff_t i = 0; i < networkSortSize; ++i) {
+        buffer[i] = i < n ? first[i] : padding;
+    }
+    bitonicSort16(buffer);
+    std::copy(buffer, buffer + n, first);
+}
@@ -0,0 +1,280 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+/// векторные ядра разбиения для int32_t, uint32_t, int64_t, uint64_t, float и double при сравнении std::less.
+/// ядро выбирается на этапе компиляции: AVX-512 (compress-store), иначе AVX2 (таблицы перестановок),
+/// иначе SimdPartitionSupported<V>::value == false и используется скалярный mypartition
+
+template <typename V>
+struct SimdPartitionSupported : std::false_type {};
+
+#if defined(__AVX512F__)
+
+template <typename V>
+struct Avx512Ops;
+
+template <>
+struct Avx512Ops<std::int32_t> {
+    static const int lanes = 16;
+    static __m512i set1(std::int32_t x) { return _mm512_set1_epi32(x); }
+    static unsigned lessMask(__m512i v, __m512i pivot) { return _mm512_cmplt_epi32_mask(v, pivot); }
+};
+
+template <>
+struct Avx512Ops<std::uint32_t> {
+    static const int lanes = 16;
+    static __m512i set1(std::uint32_t x) { return _mm512_set1_epi32(static_cast<int>(x)); }
+    static unsigned lessMask(__m512i v, __m512i pivot) { return _mm512_cmplt_epu32_mask(v, pivot); }
+};
+
+template <>
+struct Avx512Ops<float> {
+    static const int lanes = 16;
+    static __m512i set1(float x) { return _mm512_castps_si512(_mm512_set1_ps(x)); }
+    static unsigned lessMask(__m512i v, __m512i pivot) {
+        return _mm512_cmp_ps_mask(_mm512_castsi512_ps(v), _mm512_castsi512_ps(pivot), _CMP_LT_OQ);
+    }
+};
+
+template <>
+struct Avx512Ops<std::int64_t> {
+    static const int lanes = 8;
+    static __m512i set1(std::int64_t x) { return _mm512_set1_epi64(x); }
+    static unsigned lessMask(__m512i v, __m512i pivot) { return _mm512_cmplt_epi64_mask(v, pivot); }
+};
+
+template <>
+struct Avx512Ops<std::uint64_t> {
+    static const int lanes = 8;
+    static __m512i set1(std::uint64_t x) { return _mm512_set1_epi64(static_cast<long long>(x)); }
+    static unsigned lessMask(__m512i v, __m512i pivot) { return _mm512_cmplt_epu64_mask(v, pivot); }
+};
+
+template <>
+struct Avx512Ops<double> {
+    static const int lanes = 8;
+    static __m512i set1(double x) { return _mm512_castpd_si512(_mm512_set1_pd(x)); }
+    static unsigned lessMask(__m512i v, __m512i pivot) {
+        return _mm512_cmp_pd_mask(_mm512_castsi512_pd(v), _mm512_castsi512_pd(pivot), _CMP_LT_OQ);
+    }
+};
+
+template <typename V>
+struct SimdOps : Avx512Ops<V> {
+    using Reg = __m512i;
+
+    static Reg load(const V* p) { return _mm512_loadu_si512(p); }
+
+    /// меньшие опорного элементы дописываются в leftOut, остальные - перед rightOut
+    static void storePartitioned(Reg v, unsigned mask, V*& leftOut, V*& rightOut) {
+        int less = __builtin_popcount(mask);
+        int greater = Avx512Ops<V>::lanes - less;
+        storeCompressed(leftOut, mask, v);
+        storeCompressed(rightOut - greater, ~mask, v);
+        leftOut += less;
+        rightOut -= greater;
+    }
+
+    static void storeCompressed(V* p, unsigned mask, Reg v) {
+        if (sizeof(V) == 4) {
+            _mm512_mask_compressstoreu_epi32(p, static_cast<__mmask16>(mask), v);
+        } else {
+            _mm512_mask_compressstoreu_epi64(p, static_cast<__mmask8>(mask), v);
+        }
+    }
+};
+
+#elif defined(__AVX2__)
+
+template <typename V>
+struct Avx2Ops;
+
+template <>
+struct Avx2Ops<std::int32_t> {
+    static const int lanes = 8;
+    static __m256i set1(std::int32_t x) { return _mm256_set1_epi32(x); }
+    static unsigned lessMask(__m256i v, __m256i pivot) {
+        return static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(pivot, v))));
+    }
+};
+
+/// AVX2 не умеет беззнаковые сравнения: у обоих операндов инвертируется знаковый бит
+template <>
+struct Avx2Ops<std::uint32_t> {
+    static const int lanes = 8;
+    static __m256i set1(std::uint32_t x) { return _mm256_set1_epi32(static_cast<int>(x ^ 0x80000000u)); }
+    static unsigned lessMask(__m256i v, __m256i pivot) {
+        __m256i flipped = _mm256_xor_si256(v, _mm256_set1_epi32(static_cast<int>(0x80000000u)));
+        return static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(pivot, flipped))));
+    }
+};
+
+template <>
+struct Avx2Ops<float> {
+    static const int lanes = 8;
+    static __m256i set1(float x) { return _mm256_castps_si256(_mm256_set1_ps(x)); }
+    static unsigned lessMask(__m256i v, __m256i pivot) {
+        return static_cast<unsigned>(_mm256_movemask_ps(
+                _mm256_cmp_ps(_mm256_castsi256_ps(v), _mm256_castsi256_ps(pivot), _CMP_LT_OQ)));
+    }
+};
+
+template <>
+struct Avx2Ops<std::int64_t> {
+    static const int lanes = 4;
+    static __m256i set1(std::int64_t x) { return _mm256_set1_epi64x(x); }
+    static unsigned lessMask(__m256i v, __m256i pivot) {
+        return static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(pivot, v))));
+    }
+};
+
+template <>
+struct Avx2Ops<std::uint64_t> {
+    static const int lanes = 4;
+    static __m256i set1(std::uint64_t x) { return _mm256_set1_epi64x(static_cast<long long>(x ^ (1ull << 63))); }
+    static unsigned lessMask(__m256i v, __m256i pivot) {
+        __m256i flipped = _mm256_xor_si256(v, _mm256_set1_epi64x(static_cast<long long>(1ull << 63)));
+        return static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(pivot, flipped))));
+    }
+};
+
+template <>
+struct Avx2Ops<double> {
+    static const int lanes = 4;
+    static __m256i set1(double x) { return _mm256_castpd_si256(_mm256_set1_pd(x)); }
+    static unsigned lessMask(__m256i v, __m256i pivot) {
+        return static_cast<unsigned>(_mm256_movemask_pd(
+                _mm256_cmp_pd(_mm256_castsi256_pd(v), _mm256_castsi256_pd(pivot), _CMP_LT_OQ)));
+    }
+};
+
+/// для каждой маски сравнения - индексы 32-битных слов, переставляющие отмеченные линии в начало вектора,
+/// а остальные в конец. для 64-битных линий каждая линия - пара слов
+template <int Lanes>
+struct Avx2PermutationTable {
+    std::int32_t indices[1 << Lanes][8];
+
+    constexpr Avx2PermutationTable() : indices() {
+        const int wordsPerLane = 8 / Lanes;
+        for (int mask = 0; mask < (1 << Lanes); ++mask) {
+            int out = 0;
+            for (int pass = 0; pass < 2; ++pass) {
+                for (int lane = 0; lane < Lanes; ++lane) {
+                    bool selected = (mask >> lane) & 1;
+                    if (selected == (pass == 0)) {
+                        for (int word = 0; word < wordsPerLane; ++word) {
+                            indices[mask][out++] = lane * wordsPerLane + word;
+                        }
+                    }
+                }
+            }
+        }
+    }
+};
+
+template <int Lanes>
+const Avx2PermutationTable<Lanes>& avx2PermutationTable() {
+    static constexpr Avx2PermutationTable<Lanes> table{};
+    return table;
+}
+
+template <typename V>
+struct SimdOps : Avx2Ops<V> {
+    using Reg = __m256i;
+
+    static Reg load(const V* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+
+    /// вектор переставляется так, что меньшие опорного элементы идут первыми, и записывается целиком дважды:
+    /// в leftOut и вплотную перед rightOut. алгоритм разбиения гарантирует, что обе записи попадают
+    /// в уже прочитанную часть массива
+    static void storePartitioned(Reg v, unsigned mask, V*& leftOut, V*& rightOut) {
+        const int lanes = Avx2Ops<V>::lanes;
+        __m256i indices = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i*>(avx2PermutationTable<lanes>().indices[mask]));
+        Reg permuted = _mm256_permutevar8x32_epi32(v, indices);
+        int less = __builtin_popcount(mask);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(leftOut), permuted);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(rightOut - lanes), permuted);
+        leftOut += less;
+        rightOut -= lanes - less;
+    }
+};
+
+#endif
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+
+template <> struct SimdPartitionSupported<std::int32_t> : std::true_type {};
+template <> struct SimdPartitionSupported<std::uint32_t> : std::true_type {};
+template <> struct SimdPartitionSupported<std::int64_t> : std::true_type {};
+template <> struct SimdPartitionSupported<std::uint64_t> : std::true_type {};
+template <> struct SimdPartitionSupported<float> : std::true_type {};
+template <> struct SimdPartitionSupported<double> : std::true_type {};
+
+/// разбивает [first, last) относительно pivotVal; возвращает границу, левее которой все элементы меньше pivotVal.
+/// первый и последний векторы откладываются в регистры, поэтому перед записью каждого следующего вектора
+/// с обеих сторон есть не меньше lanes свободных (уже прочитанных) позиций
+template <typename V>
+V* simdPartition(V* first, V* last, V pivotVal) {
+    using Ops = SimdOps<V>;
+    const int lanes = Ops::lanes;
+
+    if (last - first < 2 * lanes) {
+        while (first < last) {
+            if (*first < pivotVal) {
+                ++first;
+            } else {
+                V tmp = *first;
+                *first = *--last;
+                *last = tmp;
+            }
+        }
+        return first;
+    }
+
+    auto pivot = Ops::set1(pivotVal);
+    auto savedLeft = Ops::load(first);
+    auto savedRight = Ops::load(last - lanes);
+
+    // непрочитанная часть - [left, right), результат пишется в [first, leftOut) и [rightOut, last)
+    V* left = first + lanes;
+    V* right = last - lanes;
+    V* leftOut = first;
+    V* rightOut = last;
+    while (right - left >= lanes) {
+        typename Ops::Reg v;
+        if (left - leftOut <= rightOut - right) {
+            v = Ops::load(left);
+            left += lanes;
+        } else {
+            right -= lanes;
+            v = Ops::load(right);
+        }
+        Ops::storePartitioned(v, Ops::lessMask(v, pivot), leftOut, rightOut);
+    }
+
+    V tail[lanes];
+    auto tailSize = right - left;
+    for (auto i = 0; i < tailSize; ++i) {
+        tail[i] = left[i];
+    }
+    for (auto i = 0; i < tailSize; ++i) {
+        if (tail[i] < pivotVal) {
+            *leftOut++ = tail[i];
+        } else {
+            *--rightOut = tail[i];
+        }
+    }
+
+    Ops::storePartitioned(savedLeft, Ops::lessMask(savedLeft, pivot), leftOut, rightOut);
+    Ops::storePartitioned(savedRight, Ops::lessMask(savedRight, pivot), leftOut, rightOut);
+    return leftOut;
+}
+
+#endif
@@ -1,9 +1,26 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "simd_network.h"
+#include "simd_partition.h"
+#include "sorting_network.h"
+#include "thread_pool.h"
 
 template <typename T, typename Comp>
-void insertionSort(const T first, const T last, Comp comp) {
+constexpr void insertionSort(const T first, const T last, Comp comp) {
     for (auto iterSortedPart = first; iterSortedPart < last; ++iterSortedPart) {
         for (auto iter = iterSortedPart; iter > first; --iter) {
             auto iterPrev = iter - 1;
@@ -17,7 +34,79 @@ void insertionSort(const T first, const T last, Comp comp) {
 }
 
 template <typename T, typename Comp>
-T mypartition(T first, T last, T pivot, Comp comp) {
+constexpr void siftDown(T first, typename std::iterator_traits<T>::difference_type n,
+              typename std::iterator_traits<T>::difference_type i, Comp comp) {
+    auto val = std::move(first[i]);
+    while (2 * i + 1 < n) {
+        auto child = 2 * i + 1;
+        if (child + 1 < n && comp(first[child], first[child + 1])) {
+            ++child;
+        }
+        if (!comp(val, first[child])) {
+            break;
+        }
+        first[i] = std::move(first[child]);
+        i = child;
+    }
+    first[i] = std::move(val);
+}
+
+template <typename T, typename Comp>
+constexpr void heapSort(T first, T last, Comp comp) {
+    auto n = std::distance(first, last);
+    for (auto i = n / 2; i > 0; --i) {
+        siftDown(first, n, i - 1, comp);
+    }
+    for (auto end = n - 1; end > 0; --end) {
+        std::swap(*first, first[end]);
+        siftDown(first, end, decltype(n)(0), comp);
+    }
+}
+
+/// данные лежат в памяти подряд и сравниваются обычным std::less
+template <typename T, typename Comp, typename V = typename std::iterator_traits<T>::value_type>
+struct IsContiguousLess
+        : std::integral_constant<bool, (std::is_same<T, V*>::value
+                                        || std::is_same<T, typename std::vector<V>::iterator>::value)
+                                       && (std::is_same<Comp, std::less<V>>::value
+                                           || std::is_same<Comp, std::less<>>::value)> {};
+
+/// векторное разбиение применимо, если для типа есть SIMD-ядро
+template <typename T, typename Comp, typename V = typename std::iterator_traits<T>::value_type>
+struct IsSimdPartitionable
+        : std::integral_constant<bool, SimdPartitionSupported<V>::value && IsContiguousLess<T, Comp>::value> {};
+
+/// листья 32-битных арифметических ключей сортируются векторной сетью без ветвлений, поэтому они длиннее
+template <typename T, typename Comp, typename V = typename std::iterator_traits<T>::value_type>
+struct IsNetworkSortable
+        : std::integral_constant<bool, SimdNetworkSupported<V>::value && IsContiguousLess<T, Comp>::value> {};
+
+template <typename T, typename Comp>
+struct SmallSortThreshold
+        : std::integral_constant<std::ptrdiff_t, IsNetworkSortable<T, Comp>::value ? networkSortSize : 7> {};
+
+template <typename T, typename Comp>
+constexpr void smallSortImpl(T first, T last, Comp comp, std::true_type) {
+    if (std::is_constant_evaluated()) {
+        insertionSort(first, last, comp);
+        return;
+    }
+    networkSort(&*first, std::distance(first, last));
+}
+
+template <typename T, typename Comp>
+constexpr void smallSortImpl(T first, T last, Comp comp, std::false_type) {
+    insertionSort(first, last, comp);
+}
+
+/// сортировка листа рекурсии длиной не больше SmallSortThreshold
+template <typename T, typename Comp>
+constexpr void smallSort(T first, T last, Comp comp) {
+    smallSortImpl(first, last, comp, IsNetworkSortable<T, Comp>());
+}
+
+template <typename T, typename Comp>
+constexpr T mypartitionImpl(T first, T last, T pivot, Comp comp, std::false_type) {
     auto pivotVal = *pivot;
     std::swap(*pivot, *--last);
     pivot = last;
@@ -33,28 +122,2128 @@ T mypartition(T first, T last, T pivot, Comp comp) {
 }
 
 template <typename T, typename Comp>
-void mysort(T first, T last, Comp comp) {
+constexpr T mypartitionImpl(T first, T last, T pivot, Comp comp, std::true_type) {
+    if (std::is_constant_evaluated()) {
+        return mypartitionImpl(first, last, pivot, comp, std::false_type());
+    }
+    auto pivotVal = *pivot;
+    std::swap(*pivot, *--last);
+    auto split = simdPartition(&*first, &*first + std::distance(first, last), pivotVal);
+    T result = first + (split - &*first);
+    std::swap(*last, *result);
+    return result;
+}
+
+template <typename T, typename Comp>
+constexpr T mypartition(T first, T last, T pivot, Comp comp) {
+    return mypartitionImpl(first, last, pivot, comp, IsSimdPartitionable<T, Comp>());
+}
+
+/// BlockQuicksort: результаты сравнений с опорным элементом записываются без ветвлений в буферы смещений
+/// по blockSize элементов с каждого края, после чего неправильно стоящие элементы меняются пачкой.
+/// контракт тот же, что у mypartition
+template <typename T, typename Comp>
+constexpr T mypartition_block(T first, T last, T pivot, Comp comp) {
+    const int blockSize = 64;
+    auto pivotVal = *pivot;
+    std::swap(*pivot, *--last);
+    pivot = last;
+
+    unsigned char offsetsLeft[blockSize];
+    unsigned char offsetsRight[blockSize];
+    int startLeft = 0;
+    int startRight = 0;
+    int numLeft = 0;
+    int numRight = 0;
+
+    // [first, left) < pivotVal, [right, last) >= pivotVal
+    T left = first;
+    T right = last;
+    while (std::distance(left, right) > 2 * blockSize) {
+        if (numLeft == 0) {
+            startLeft = 0;
+            for (int i = 0; i < blockSize; ++i) {
+                offsetsLeft[numLeft] = static_cast<unsigned char>(i);
+                numLeft += !comp(left[i], pivotVal);
+            }
+        }
+        if (numRight == 0) {
+            startRight = 0;
+            for (int i = 0; i < blockSize; ++i) {
+                offsetsRight[numRight] = static_cast<unsigned char>(i);
+                numRight += comp(*(right - 1 - i), pivotVal);
+            }
+        }
+
+        int num = std::min(numLeft, numRight);
+        for (int i = 0; i < num; ++i) {
+            std::swap(left[offsetsLeft[startLeft + i]], *(right - 1 - offsetsRight[startRight + i]));
+        }
+        numLeft -= num;
+        numRight -= num;
+        startLeft += num;
+        startRight += num;
+
+        if (numLeft == 0) {
+            left += blockSize;
+        }
+        if (numRight == 0) {
+            right -= blockSize;
+        }
+    }
+
+    // остаток меньше двух блоков досортировывается обычным разбиением
+    while (left < right) {
+        if (comp(*left, pivotVal)) {
+            ++left;
+        } else {
+            std::swap(*left, *--right);
+        }
+    }
+    std::swap(*pivot, *left);
+    return left;
+}
+
+/// стратегии разбиения для mysort
+struct DefaultPartition {
+    template <typename T, typename Comp>
+    constexpr T operator()(T first, T last, T pivot, Comp comp) const {
+        return mypartition(first, last, pivot, comp);
+    }
+};
+
+/// разбиение без ветвлений, выгодно для арифметических и дешево сравниваемых ключей
+struct BlockPartition {
+    template <typename T, typename Comp>
+    constexpr T operator()(T first, T last, T pivot, Comp comp) const {
+        return mypartition_block(first, last, pivot, comp);
+    }
+};
+
+template <typename T, typename Comp>
+constexpr T medianOf3(T a, T b, T c, Comp comp) {
+    if (comp(*a, *b)) {
+        if (comp(*b, *c)) {
+            return b;
+        }
+        return comp(*a, *c) ? c : a;
+    }
+    if (comp(*a, *c)) {
+        return a;
+    }
+    return comp(*b, *c) ? c : b;
+}
+
+/// стратегии выбора опорного элемента для mysort: возвращают итератор на опорный элемент, не переставляя данные
+struct MiddlePivot {
+    template <typename T, typename Comp>
+    constexpr T operator()(T first, T last, Comp) const {
+        return first + std::distance(first, last) / 2;
+    }
+};
+
+struct MedianOfThreePivot {
+    template <typename T, typename Comp>
+    constexpr T operator()(T first, T last, Comp comp) const {
+        return medianOf3(first, first + std::distance(first, last) / 2, last - 1, comp);
+    }
+};
+
+/// медиана трех медиан Тьюки
+struct NintherPivot {
+    template <typename T, typename Comp>
+    constexpr T operator()(T first, T last, Comp comp) const {
+        auto n = std::distance(first, last);
+        auto step = n / 8;
+        T mid = first + n / 2;
+        return medianOf3(medianOf3(first, first + step, first + 2 * step, comp),
+                         medianOf3(mid - step, mid, mid + step, comp),
+                         medianOf3(last - 1 - 2 * step, last - 1 - step, last - 1, comp),
+                         comp);
+    }
+};
+
+/// медиана трех случайных элементов; генератор (splitmix64) задается seed'ом, так что порядок
+/// сравнений воспроизводим
+struct RandomPivot {
+    std::uint64_t state;
+
+    constexpr explicit RandomPivot(std::uint64_t seed = 0) : state(seed) {}
+
+    constexpr std::uint64_t next() {
+        std::uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+
+    template <typename T, typename Comp>
+    constexpr T operator()(T first, T last, Comp comp) {
+        auto n = static_cast<std::uint64_t>(std::distance(first, last));
+        T a = first + static_cast<std::ptrdiff_t>(next() % n);
+        T b = first + static_cast<std::ptrdiff_t>(next() % n);
+        T c = first + static_cast<std::ptrdiff_t>(next() % n);
+        return medianOf3(a, b, c, comp);
+    }
+};
+
+/// медиана трех на небольших отрезках, медиана медиан на больших
+struct DefaultPivot {
+    template <typename T, typename Comp>
+    constexpr T operator()(T first, T last, Comp comp) const {
+        if (std::distance(first, last) > 128) {
+            return NintherPivot()(first, last, comp);
+        }
+        return MedianOfThreePivot()(first, last, comp);
+    }
+};
+
+/// разбиение на три части: [first, lt) < pivot, [lt, gt) == pivot, [gt, last) > pivot
+template <typename T, typename Comp>
+constexpr std::pair<T, T> mypartition3way(T first, T last, T pivot, Comp comp) {
+    auto pivotVal = *pivot;
+    T lt = first;
+    T gt = last;
+    while (first < gt) {
+        if (comp(*first, pivotVal)) {
+            std::swap(*lt++, *first++);
+        } else if (comp(pivotVal, *first)) {
+            std::swap(*first, *--gt);
+        } else {
+            ++first;
+        }
+    }
+    return {lt, gt};
+}
+
+constexpr int floorLog2(std::size_t n) {
+    int log = 0;
+    while (n >>= 1) {
+        ++log;
+    }
+    return log;
+}
+
+/// один шаг разбиения introSort: возвращает [leftEnd, rightBegin) - элементы, уже стоящие на своих местах
+template <typename T, typename Comp, typename Partition, typename Pivot>
+constexpr std::pair<T, T> introPartition(T first, T last, Comp comp, bool leftmost, Partition& partition, Pivot& pivotPolicy) {
+    T pivot = pivotPolicy(first, last, comp);
+    if (!leftmost && !comp(*(first - 1), *pivot)) {
+        return mypartition3way(first, last, pivot, comp);
+    }
+    pivot = partition(first, last, pivot, comp);
+    return {pivot, pivot + 1};
+}
+
+/// quicksort, который после depthLimit неудачных разбиений досортировывает подотрезок heapSort'ом,
+/// поэтому худший случай O(n log n).
+/// если отрезок не самый левый, то *(first - 1) не больше любого его элемента; когда опорный элемент
+/// с ним равен, в отрезке есть дубликаты и равные опорному элементы отделяются трехчастным разбиением
+/// стратегии передаются по ссылке, чтобы состояние (например, генератор RandomPivot) продвигалось
+/// через всю сортировку, а не копировалось в каждый подотрезок
+template <typename T, typename Comp, typename Partition, typename Pivot>
+constexpr void introSortLoop(T first, T last, Comp comp, int depthLimit, bool leftmost,
+                             Partition& partition, Pivot& pivotPolicy) {
     while (first < last) {
         auto n = std::distance(first, last);
         if (n < 2) {
             return;
         }
-        if (n < 8) {
-            insertionSort(first, last, comp);
+        if (n <= SmallSortThreshold<T, Comp>::value) {
+            smallSort(first, last, comp);
+            return;
+        }
+        if (depthLimit == 0) {
+            heapSort(first, last, comp);
             return;
         }
+        --depthLimit;
 
-        T pivot = mypartition(first, last, first + n / 2, comp);
+        auto bounds = introPartition(first, last, comp, leftmost, partition, pivotPolicy);
+        T leftEnd = bounds.first;
+        T rightBegin = bounds.second;
 
-        auto n1 = std::distance(first, pivot);
-        auto n2 = std::distance(pivot + 1, last);
+        auto n1 = std::distance(first, leftEnd);
+        auto n2 = std::distance(rightBegin, last);
 
         if (n1 < n2) {
-            mysort(first, pivot, comp);
+            introSortLoop(first, leftEnd, comp, depthLimit, leftmost, partition, pivotPolicy);
+            first = rightBegin;
+            leftmost = false;
+        } else {
+            introSortLoop(rightBegin, last, comp, depthLimit, false, partition, pivotPolicy);
+            last = leftEnd;
+        }
+    }
+}
+
+template <typename T, typename Comp, typename Partition = DefaultPartition, typename Pivot = DefaultPivot>
+constexpr void introSort(T first, T last, Comp comp, int depthLimit, bool leftmost = true,
+               Partition partition = Partition(), Pivot pivotPolicy = Pivot()) {
+    introSortLoop(first, last, comp, depthLimit, leftmost, partition, pivotPolicy);
+}
+
+template <typename T, typename Comp>
+constexpr void medianOfMediansSelect(T first, T nth, T last, Comp comp);
+
+/// медиана медиан пятерок (Blum, Floyd, Pratt, Rivest, Tarjan): не меньше и не больше примерно 3/10 элементов
+/// отрезка. медианы пятерок собираются в начало отрезка
+template <typename T, typename Comp>
+constexpr T medianOfMedians(T first, T last, Comp comp) {
+    auto n = std::distance(first, last);
+    if (n <= 5) {
+        insertionSort(first, last, comp);
+        return first + n / 2;
+    }
+    T medians = first;
+    for (T group = first; std::distance(group, last) >= 5; group += 5) {
+        insertionSort(group, group + 5, comp);
+        std::iter_swap(medians++, group + 2);
+    }
+    T mid = first + std::distance(first, medians) / 2;
+    medianOfMediansSelect(first, mid, medians, comp);
+    return mid;
+}
+
+/// выбор с гарантированно линейным временем: опорный элемент - медиана медиан, равные ему элементы
+/// отделяются трехчастным разбиением, поэтому дубликаты не замедляют выбор
+template <typename T, typename Comp>
+constexpr void medianOfMediansSelect(T first, T nth, T last, Comp comp) {
+    while (std::distance(first, last) > 5) {
+        auto bounds = mypartition3way(first, last, medianOfMedians(first, last, comp), comp);
+        if (nth < bounds.first) {
+            last = bounds.first;
+        } else if (nth < bounds.second) {
+            return;
+        } else {
+            first = bounds.second;
+        }
+    }
+    insertionSort(first, last, comp);
+}
+
+/// introselect (Musser): quickselect на mypartition с опорным элементом DefaultPivot. если отрезок несколько раз
+/// не уменьшился хотя бы на четверть, опорный элемент неудачен (или много дубликатов) и выбор продолжается
+/// медианой медиан, поэтому худший случай O(n)
+template <typename T, typename Comp>
+constexpr void introSelect(T first, T nth, T last, Comp comp, int badPartitionLimit) {
+    DefaultPivot pivotPolicy;
+    while (std::distance(first, last) > SmallSortThreshold<T, Comp>::value) {
+        if (badPartitionLimit == 0) {
+            medianOfMediansSelect(first, nth, last, comp);
+            return;
+        }
+        auto n = std::distance(first, last);
+        T pivot = mypartition(first, last, pivotPolicy(first, last, comp), comp);
+        if (pivot == nth) {
+            return;
+        }
+        if (nth < pivot) {
+            last = pivot;
+        } else {
             first = pivot + 1;
+        }
+        if (std::distance(first, last) > n / 4 * 3) {
+            --badPartitionLimit;
+        }
+    }
+    smallSort(first, last, comp);
+}
+
+/// переставляет [first, last) так, что на месте nth стоит элемент, который стоял бы там после сортировки,
+/// левее - не большие его, правее - не меньшие. в среднем и в худшем случае O(n)
+template <typename T, typename Comp>
+constexpr void mynth_element(T first, T nth, T last, Comp comp) {
+    if (nth == last || std::distance(first, last) < 2) {
+        return;
+    }
+    const int badPartitionLimit = 4;
+    introSelect(first, nth, last, comp, badPartitionLimit);
+}
+
+/// рекурсивный выбор нескольких порядковых статистик: [rankFirst, rankLast) - отсортированные номера относительно
+/// begin, попадающие в [first, last). разбиение продолжается только в частях, где остались запрошенные номера;
+/// как и в introSelect, после badPartitionLimit неудачных разбиений опорным элементом становится медиана медиан
+template <typename T, typename R, typename Comp>
+void multiSelect(T begin, T first, T last, R rankFirst, R rankLast, Comp comp, int badPartitionLimit) {
+    DefaultPivot pivotPolicy;
+    while (rankFirst != rankLast) {
+        if (rankLast - rankFirst == 1) {
+            introSelect(first, begin + *rankFirst, last, comp, badPartitionLimit);
+            return;
+        }
+        auto n = std::distance(first, last);
+        if (n <= SmallSortThreshold<T, Comp>::value) {
+            smallSort(first, last, comp);
+            return;
+        }
+
+        std::pair<T, T> bounds;
+        if (badPartitionLimit == 0) {
+            bounds = mypartition3way(first, last, medianOfMedians(first, last, comp), comp);
+        } else {
+            T pivot = mypartition(first, last, pivotPolicy(first, last, comp), comp);
+            bounds = {pivot, pivot + 1};
+        }
+        if (std::max(std::distance(first, bounds.first), std::distance(bounds.second, last)) > n / 4 * 3
+            && badPartitionLimit > 0) {
+            --badPartitionLimit;
+        }
+
+        // номера из [bounds.first, bounds.second) уже на своих местах
+        auto leftRanks = std::lower_bound(rankFirst, rankLast, static_cast<std::size_t>(bounds.first - begin));
+        auto rightRanks = std::lower_bound(leftRanks, rankLast, static_cast<std::size_t>(bounds.second - begin));
+        if (std::distance(first, bounds.first) < std::distance(bounds.second, last)) {
+            multiSelect(begin, first, bounds.first, rankFirst, leftRanks, comp, badPartitionLimit);
+            first = bounds.second;
+            rankFirst = rightRanks;
+        } else {
+            multiSelect(begin, bounds.second, last, rightRanks, rankLast, comp, badPartitionLimit);
+            last = bounds.first;
+            rankLast = leftRanks;
+        }
+    }
+}
+
+/// находит сразу несколько порядковых статистик: ranks - отсортированные по возрастанию номера (0 - минимум),
+/// меньшие n, повторы допускаются. после вызова на каждой позиции из ranks стоит тот же элемент, что и после
+/// сортировки, а между соседними номерами - элементы, лежащие между ними по порядку. возвращает значения
+/// в порядке ranks
+template <typename T, typename Comp>
+std::vector<typename std::iterator_traits<T>::value_type> mymulti_select(T first, T last,
+                                                                         const std::vector<std::size_t>& ranks,
+                                                                         Comp comp) {
+    const int badPartitionLimit = 4;
+    multiSelect(first, first, last, ranks.begin(), ranks.end(), comp, badPartitionLimit);
+
+    std::vector<typename std::iterator_traits<T>::value_type> values;
+    values.reserve(ranks.size());
+    for (auto rank : ranks) {
+        values.push_back(first[rank]);
+    }
+    return values;
+}
+
+/// беззнаковый ключ, порядок которого совпадает с порядком значений: у знаковых типов инвертируется знаковый бит
+template <typename V, typename = void>
+struct RadixKey {
+    static const bool supported = false;
+};
+
+template <typename V>
+struct RadixKey<V, std::enable_if_t<std::is_integral<V>::value && !std::is_same<V, bool>::value>> {
+    static const bool supported = true;
+    using Key = std::make_unsigned_t<V>;
+
+    static Key toKey(V value) {
+        auto key = static_cast<Key>(value);
+        if (std::is_signed<V>::value) {
+            key ^= Key(1) << (8 * sizeof(Key) - 1);
+        }
+        return key;
+    }
+};
+
+/// у неотрицательных чисел с плавающей точкой инвертируется знаковый бит, у отрицательных - все биты
+template <typename V>
+struct RadixKey<V, std::enable_if_t<std::is_floating_point<V>::value && (sizeof(V) == 4 || sizeof(V) == 8)>> {
+    static const bool supported = true;
+    using Key = std::conditional_t<sizeof(V) == 4, std::uint32_t, std::uint64_t>;
+
+    static Key toKey(V value) {
+        const Key sign = Key(1) << (8 * sizeof(Key) - 1);
+        auto bits = std::bit_cast<Key>(value);
+        return (bits & sign) ? static_cast<Key>(~bits) : static_cast<Key>(bits | sign);
+    }
+};
+
+/// ключ для устойчивых сортировок: -0.0 и +0.0 равны по std::less, поэтому им нужен один и тот же ключ,
+/// иначе все -0.0 встанут перед всеми +0.0 независимо от исходного порядка
+template <typename V>
+typename RadixKey<V>::Key stableRadixKey(V value) {
+    if constexpr (std::is_floating_point<V>::value) {
+        value = value == V(0) ? V(0) : value;
+    }
+    return RadixKey<V>::toKey(value);
+}
+
+/// 1 - сравнение по возрастанию (std::less), -1 - по убыванию (std::greater), 0 - произвольный компаратор
+template <typename Comp, typename V>
+struct RadixOrder
+        : std::integral_constant<int, std::is_same<Comp, std::less<V>>::value || std::is_same<Comp, std::less<>>::value
+                                      ? 1
+                                      : std::is_same<Comp, std::greater<V>>::value
+                                                || std::is_same<Comp, std::greater<>>::value
+                                        ? -1
+                                        : 0> {};
+
+template <typename T, typename Comp, typename V = typename std::iterator_traits<T>::value_type>
+struct IsRadixSortable
+        : std::integral_constant<bool, std::is_integral<V>::value && RadixKey<V>::supported
+                                       && RadixOrder<Comp, V>::value != 0> {};
+
+/// начиная с такой длины mysort сортирует целые ключи поразрядной сортировкой. векторное разбиение
+/// обгоняет ее на отрезках до нескольких десятков тысяч элементов
+template <typename T, typename Comp>
+struct RadixSortThreshold
+        : std::integral_constant<std::ptrdiff_t, IsSimdPartitionable<T, Comp>::value ? (1 << 14) : (1 << 11)> {};
+
+template <typename Src, typename Dst, typename KeyFn>
+void radixScatter(Src first, Src last, Dst out, KeyFn key, int shift, std::ptrdiff_t* offsets) {
+    for (; first != last; ++first) {
+        auto digit = (key(*first) >> shift) & 0xff;
+        out[offsets[digit]++] = std::move(*first);
+    }
+}
+
+/// LSD поразрядная сортировка по байтам беззнакового ключа key(x) через буфер размера n. гистограммы всех
+/// разрядов считаются за один проход, разряды, одинаковые у всех элементов, пропускаются. сортировка устойчива
+template <typename T, typename KeyFn>
+void lsdRadixSortByKey(T first, T last, KeyFn key) {
+    using V = typename std::iterator_traits<T>::value_type;
+    using Key = std::decay_t<decltype(key(*first))>;
+    const int digits = sizeof(Key);
+
+    auto n = std::distance(first, last);
+    if (n < 2) {
+        return;
+    }
+
+    std::vector<std::array<std::ptrdiff_t, 256>> counts(digits);
+    for (auto& count : counts) {
+        count.fill(0);
+    }
+    for (auto iter = first; iter != last; ++iter) {
+        Key k = key(*iter);
+        for (int d = 0; d < digits; ++d) {
+            ++counts[d][(k >> (8 * d)) & 0xff];
+        }
+    }
+
+    std::vector<V> buffer(n);
+    bool inBuffer = false;
+    for (int d = 0; d < digits; ++d) {
+        auto& count = counts[d];
+        if (std::find(count.begin(), count.end(), n) != count.end()) {
+            continue;
+        }
+        std::ptrdiff_t offsets[256];
+        std::ptrdiff_t sum = 0;
+        for (int digit = 0; digit < 256; ++digit) {
+            offsets[digit] = sum;
+            sum += count[digit];
+        }
+        if (inBuffer) {
+            radixScatter(buffer.begin(), buffer.end(), first, key, 8 * d, offsets);
         } else {
-            mysort(pivot + 1, last, comp);
-            last = pivot - 1;
+            radixScatter(first, last, buffer.begin(), key, 8 * d, offsets);
+        }
+        inBuffer = !inBuffer;
+    }
+    if (inBuffer) {
+        std::move(buffer.begin(), buffer.end(), first);
+    }
+}
+
+/// LSD поразрядная сортировка при сравнении std::less или std::greater; порядок произвольного компаратора
+/// ключом не выражается, поэтому такие отрезки сортируются introSort'ом
+template <typename T, typename Comp>
+void myradix_sort(T first, T last, [[maybe_unused]] Comp comp) {
+    using V = typename std::iterator_traits<T>::value_type;
+    if constexpr (RadixOrder<Comp, V>::value == 0) {
+        introSort(first, last, comp, 2 * floorLog2(std::distance(first, last)));
+    } else {
+        using Key = typename RadixKey<V>::Key;
+        const Key orderMask = RadixOrder<Comp, V>::value < 0 ? static_cast<Key>(~Key(0)) : Key(0);
+        lsdRadixSortByKey(first, last, [orderMask](const V& value) {
+            return static_cast<Key>(RadixKey<V>::toKey(value) ^ orderMask);
+        });
+    }
+}
+
+template <typename T, typename Comp, typename V = typename std::iterator_traits<T>::value_type>
+struct IsMultikeySortable
+        : std::integral_constant<bool, (std::is_same<V, std::string>::value || std::is_same<V, std::string_view>::value)
+                                       && (std::is_same<Comp, std::less<V>>::value
+                                           || std::is_same<Comp, std::less<>>::value)
+                                       && std::is_base_of<std::random_access_iterator_tag,
+                                                          typename std::iterator_traits<T>::iterator_category>::value> {};
+
+/// символ строки на позиции depth как unsigned char (так сравнивает std::char_traits<char>), -1 за концом строки
+inline int multikeyChar(std::string_view s, std::size_t depth) {
+    return depth < s.size() ? static_cast<unsigned char>(s[depth]) : -1;
+}
+
+/// строки [first, last) имеют общий префикс длины depth: он пропускается при сравнении
+template <typename T>
+void multikeyFallback(T first, T last, std::size_t depth, bool heap) {
+    using V = typename std::iterator_traits<T>::value_type;
+    auto comp = [depth](const V& a, const V& b) {
+        return std::string_view(a).substr(depth) < std::string_view(b).substr(depth);
+    };
+    if (heap) {
+        heapSort(first, last, comp);
+    } else {
+        insertionSort(first, last, comp);
+    }
+}
+
+/// multikey quicksort (Bentley, Sedgewick. Fast Algorithms for Sorting and Searching Strings): тройное разбиение
+/// по одному символу на позиции depth. меньшие и большие части сортируются по тому же символу, равные -
+/// по следующему, поэтому общий префикс не сравнивается повторно, а строки только обмениваются, но не копируются.
+/// как и в introSort, при слишком глубокой рекурсии по одному символу отрезок досортировывается heapSort
+template <typename T>
+void multikeySort(T first, T last, std::size_t depth, int depthLimit) {
+    const std::ptrdiff_t insertionSortSize = 16;
+
+    while (last - first > insertionSortSize) {
+        if (depthLimit == 0) {
+            multikeyFallback(first, last, depth, true);
+            return;
+        }
+        --depthLimit;
+
+        int a = multikeyChar(*first, depth);
+        int b = multikeyChar(*(first + (last - first) / 2), depth);
+        int c = multikeyChar(*(last - 1), depth);
+        int pivot = std::max(std::min(a, b), std::min(std::max(a, b), c));
+
+        T lt = first;
+        T i = first;
+        T gt = last;
+        while (i < gt) {
+            int ch = multikeyChar(*i, depth);
+            if (ch < pivot) {
+                std::iter_swap(lt++, i++);
+            } else if (ch > pivot) {
+                std::iter_swap(i, --gt);
+            } else {
+                ++i;
+            }
+        }
+
+        multikeySort(first, lt, depth, depthLimit);
+        multikeySort(gt, last, depth, depthLimit);
+        if (pivot < 0) {
+            // равные части - строки, закончившиеся на depth
+            return;
+        }
+        if (lt == first && gt == last) {
+            // символ на depth у всех одинаков: общий префикс пропускается за один проход, а не по символу
+            std::string_view head(*first);
+            std::size_t common = head.size();
+            for (T iter = first + 1; iter != last && common > depth + 1; ++iter) {
+                std::string_view s(*iter);
+                auto limit = std::min(common, s.size());
+                auto mismatch = std::mismatch(head.begin() + depth + 1, head.begin() + limit, s.begin() + depth + 1);
+                common = static_cast<std::size_t>(mismatch.first - head.begin());
+            }
+            depth = std::max(common, depth + 1);
+            continue;
+        }
+        first = lt;
+        last = gt;
+        ++depth;
+        depthLimit = 2 * floorLog2(last - first);
+    }
+    multikeyFallback(first, last, depth, false);
+}
+
+template <typename T>
+void mymultikey_sort(T first, T last) {
+    auto n = std::distance(first, last);
+    if (n < 2) {
+        return;
+    }
+    multikeySort(first, last, 0, 2 * floorLog2(n));
+}
+
+/// элемент поразрядной сортировки строк: 8 байт строки, начиная с позиции, кратной 8, лежат рядом со ссылкой
+/// на строку, поэтому разбиение по корзинам и большинство сравнений не обращаются к памяти самих строк
+struct StringRadixEntry {
+    std::uint64_t cache;
+    std::string_view view;
+    std::size_t index;
+};
+
+/// байты [base, base + 8) строки старшими байтами вперед, за концом строки - нули
+inline std::uint64_t loadStringCache(std::string_view s, std::size_t base) {
+    std::uint64_t cache = 0;
+    for (std::size_t i = 0; i < 8; ++i) {
+        cache <<= 8;
+        if (base + i < s.size()) {
+            cache |= static_cast<unsigned char>(s[base + i]);
+        }
+    }
+    return cache;
+}
+
+/// сравнение строк с общим префиксом длины base по кэшу окна [base, base + 8): нулевой байт кэша и конец строки
+/// различаются по числу байт строки в окне
+inline bool stringRadixLess(const StringRadixEntry& a, const StringRadixEntry& b, std::size_t base) {
+    if (a.cache != b.cache) {
+        return a.cache < b.cache;
+    }
+    auto aLength = std::min<std::size_t>(a.view.size() - base, 8);
+    auto bLength = std::min<std::size_t>(b.view.size() - base, 8);
+    if (aLength != bLength || aLength < 8) {
+        return aLength < bLength;
+    }
+    return a.view.substr(base + 8) < b.view.substr(base + 8);
+}
+
+/// MSD поразрядная сортировка по байту на позиции depth: корзина 0 - строки, закончившиеся до depth, остальные -
+/// значение байта + 1. кэш перечитывается раз в 8 байт, корзины раскладываются на месте по циклам, как
+/// в msdRadixSortImpl. меньшие корзины сортируются рекурсивно, самая большая - в цикле, поэтому глубина
+/// рекурсии не больше log n
+inline void stringRadixSortImpl(StringRadixEntry* first, StringRadixEntry* last, std::size_t depth) {
+    const std::ptrdiff_t insertionSortSize = 32;
+
+    while (last - first > 1) {
+        if (depth % 8 == 0) {
+            bool same = true;
+            for (auto entry = first; entry != last; ++entry) {
+                entry->cache = loadStringCache(entry->view, depth);
+                same = same && entry->cache == first->cache && entry->view.size() >= depth + 8;
+            }
+            if (same) {
+                // у всех строк следующие 8 байт совпадают
+                depth += 8;
+                continue;
+            }
+        }
+        auto base = depth & ~std::size_t(7);
+        if (last - first <= insertionSortSize) {
+            insertionSort(first, last, [base](const StringRadixEntry& a, const StringRadixEntry& b) {
+                return stringRadixLess(a, b, base);
+            });
+            return;
+        }
+
+        auto shift = 56 - 8 * static_cast<int>(depth - base);
+        auto bucket = [depth, shift](const StringRadixEntry& entry) {
+            return depth < entry.view.size() ? static_cast<int>((entry.cache >> shift) & 0xff) + 1 : 0;
+        };
+        std::ptrdiff_t counts[257] = {};
+        for (auto entry = first; entry != last; ++entry) {
+            ++counts[bucket(*entry)];
+        }
+        std::ptrdiff_t heads[257];
+        std::ptrdiff_t ends[257];
+        std::ptrdiff_t sum = 0;
+        int largest = 0;
+        for (int b = 0; b < 257; ++b) {
+            heads[b] = sum;
+            sum += counts[b];
+            ends[b] = sum;
+            if (counts[b] > counts[largest]) {
+                largest = b;
+            }
+        }
+        if (counts[largest] != last - first) {
+            for (int b = 0; b < 257; ++b) {
+                while (heads[b] < ends[b]) {
+                    auto entry = first[heads[b]];
+                    auto d = bucket(entry);
+                    while (d != b) {
+                        std::swap(entry, first[heads[d]++]);
+                        d = bucket(entry);
+                    }
+                    first[heads[b]++] = entry;
+                }
+            }
+        }
+
+        // корзина 0 состоит из равных строк
+        for (int b = 1; b < 257; ++b) {
+            if (b != largest && counts[b] > 1) {
+                stringRadixSortImpl(first + ends[b] - counts[b], first + ends[b], depth + 1);
+            }
+        }
+        if (largest == 0) {
+            return;
+        }
+        last = first + ends[largest];
+        first = last - counts[largest];
+        ++depth;
+    }
+}
+
+/// поразрядная сортировка std::string или std::string_view по возрастанию: сортируется массив StringRadixEntry,
+/// затем строки переносятся на свои места
+template <typename T>
+void mystring_radix_sort(T first, T last) {
+    using V = typename std::iterator_traits<T>::value_type;
+    auto n = std::distance(first, last);
+    if (n < 2) {
+        return;
+    }
+
+    std::vector<StringRadixEntry> entries(n);
+    for (std::ptrdiff_t i = 0; i < n; ++i) {
+        entries[i] = {0, std::string_view(first[i]), static_cast<std::size_t>(i)};
+    }
+    stringRadixSortImpl(entries.data(), entries.data() + n, 0);
+
+    std::vector<V> sorted;
+    sorted.reserve(n);
+    for (auto& entry : entries) {
+        sorted.push_back(std::move(first[entry.index]));
+    }
+    std::move(sorted.begin(), sorted.end(), first);
+}
+
+template <typename T, typename Comp, typename Partition = DefaultPartition, typename Pivot = DefaultPivot>
+constexpr void mysort(T first, T last, Comp comp, Partition partition = Partition(), Pivot pivot = Pivot()) {
+    auto n = std::distance(first, last);
+    if (n < 2) {
+        return;
+    }
+    if constexpr (IsRadixSortable<T, Comp>::value && std::is_same<Partition, DefaultPartition>::value
+                  && std::is_same<Pivot, DefaultPivot>::value) {
+        if (!std::is_constant_evaluated() && n >= RadixSortThreshold<T, Comp>::value) {
+            myradix_sort(first, last, comp);
+            return;
         }
+    } else if constexpr (IsMultikeySortable<T, Comp>::value && std::is_same<Partition, DefaultPartition>::value
+                         && std::is_same<Pivot, DefaultPivot>::value) {
+        // на коротких отрезках выделение памяти под StringRadixEntry дороже выигрыша от кэша префиксов
+        const std::ptrdiff_t stringRadixSortThreshold = 128;
+        if (!std::is_constant_evaluated()) {
+            if (n >= stringRadixSortThreshold) {
+                mystring_radix_sort(first, last);
+            } else {
+                mymultikey_sort(first, last);
+            }
+            return;
+        }
+    }
+    introSort(first, last, comp, 2 * floorLog2(n), true, partition, pivot);
+}
+
+/// разбивает [first, last) относительно значения: возвращает границу, левее которой все элементы меньше pivotVal
+template <typename T, typename V, typename Comp>
+constexpr T partitionByValue(T first, T last, const V& pivotVal, Comp comp) {
+    while (first < last) {
+        if (comp(*first, pivotVal)) {
+            ++first;
+        } else {
+            std::swap(*first, *--last);
+        }
+    }
+    return first;
+}
+
+/// параллельное разбиение: отрезок делится на куски по числу потоков, куски разбиваются одновременно,
+/// затем большие элементы, оказавшиеся левее итоговой границы, параллельно меняются местами
+/// с малыми, оказавшимися правее. контракт тот же, что у mypartition
+template <typename T, typename Comp>
+T mypartition_parallel(T first, T last, T pivot, Comp comp, ThreadPool& pool) {
+    using Interval = std::pair<std::ptrdiff_t, std::ptrdiff_t>;
+    const std::ptrdiff_t minChunk = 1 << 12;
+
+    auto pivotVal = *pivot;
+    std::swap(*pivot, *--last);
+    pivot = last;
+
+    auto n = std::distance(first, last);
+    auto chunks = std::min<std::ptrdiff_t>(static_cast<std::ptrdiff_t>(pool.size()), n / minChunk);
+    if (chunks < 2) {
+        T split = partitionByValue(first, last, pivotVal, comp);
+        std::swap(*pivot, *split);
+        return split;
+    }
+
+    std::vector<std::ptrdiff_t> bounds(chunks + 1);
+    std::vector<std::ptrdiff_t> splits(chunks);
+    for (std::ptrdiff_t i = 0; i <= chunks; ++i) {
+        bounds[i] = n * i / chunks;
+    }
+    {
+        TaskGroup group(pool);
+        for (std::ptrdiff_t i = 0; i < chunks; ++i) {
+            group.run([&, i] {
+                splits[i] = std::distance(first, partitionByValue(first + bounds[i], first + bounds[i + 1], pivotVal, comp));
+            });
+        }
+        group.wait();
+    }
+
+    std::ptrdiff_t border = 0;
+    for (std::ptrdiff_t i = 0; i < chunks; ++i) {
+        border += splits[i] - bounds[i];
+    }
+
+    // большие элементы левее border и малые правее него; суммарные длины равны
+    std::vector<Interval> misplacedBig;
+    std::vector<Interval> misplacedSmall;
+    for (std::ptrdiff_t i = 0; i < chunks; ++i) {
+        if (splits[i] < std::min(bounds[i + 1], border)) {
+            misplacedBig.emplace_back(splits[i], std::min(bounds[i + 1], border));
+        }
+        if (std::max(bounds[i], border) < splits[i]) {
+            misplacedSmall.emplace_back(std::max(bounds[i], border), splits[i]);
+        }
+    }
+
+    auto prefixLengths = [](const std::vector<Interval>& intervals) {
+        std::vector<std::ptrdiff_t> prefix(1, 0);
+        for (auto& interval : intervals) {
+            prefix.push_back(prefix.back() + interval.second - interval.first);
+        }
+        return prefix;
+    };
+    auto bigPrefix = prefixLengths(misplacedBig);
+    auto smallPrefix = prefixLengths(misplacedSmall);
+    auto misplaced = bigPrefix.back();
+
+    // k-й неправильно стоящий большой элемент меняется с k-м неправильно стоящим малым
+    auto swapRange = [&](std::ptrdiff_t from, std::ptrdiff_t to) {
+        if (from >= to) {
+            return;
+        }
+        std::size_t big = std::upper_bound(bigPrefix.begin(), bigPrefix.end(), from) - bigPrefix.begin() - 1;
+        std::size_t small = std::upper_bound(smallPrefix.begin(), smallPrefix.end(), from) - smallPrefix.begin() - 1;
+        auto bigPos = misplacedBig[big].first + (from - bigPrefix[big]);
+        auto smallPos = misplacedSmall[small].first + (from - smallPrefix[small]);
+        for (auto k = from; k < to; ++k) {
+            if (bigPos == misplacedBig[big].second) {
+                bigPos = misplacedBig[++big].first;
+            }
+            if (smallPos == misplacedSmall[small].second) {
+                smallPos = misplacedSmall[++small].first;
+            }
+            std::swap(first[bigPos++], first[smallPos++]);
+        }
+    };
+    if (misplaced < minChunk) {
+        swapRange(0, misplaced);
+    } else {
+        TaskGroup group(pool);
+        for (std::ptrdiff_t i = 0; i < chunks; ++i) {
+            group.run([&, i] { swapRange(misplaced * i / chunks, misplaced * (i + 1) / chunks); });
+        }
+        group.wait();
+    }
+
+    T split = first + border;
+    std::swap(*pivot, *split);
+    return split;
+}
+
+/// стратегия разбиения для верхних уровней myparallel_sort
+struct ParallelPartition {
+    ThreadPool& pool;
+
+    template <typename T, typename Comp>
+    T operator()(T first, T last, T pivot, Comp comp) const {
+        return mypartition_parallel(first, last, pivot, comp, pool);
+    }
+};
+
+/// k наименьших элементов за один проход: [first, middle) поддерживается как max-куча, и каждый элемент хвоста,
+/// меньший вершины, заменяет ее. затем куча сортируется
+template <typename T, typename Comp>
+void heapSelectSort(T first, T middle, T last, Comp comp) {
+    auto k = std::distance(first, middle);
+    for (auto i = k / 2; i > 0; --i) {
+        siftDown(first, k, i - 1, comp);
+    }
+    for (T iter = middle; iter != last; ++iter) {
+        if (comp(*iter, *first)) {
+            std::swap(*iter, *first);
+            siftDown(first, k, decltype(k)(0), comp);
+        }
+    }
+    mysort(first, middle, comp);
+}
+
+/// mypartial_sort выбирает кучу, если k * ratio <= n. векторный mypartition проходит массив в разы быстрее
+/// кучи, поэтому с ним куча выгодна только для совсем маленьких k
+template <typename T, typename Comp>
+struct PartialSortHeapRatio
+        : std::integral_constant<std::ptrdiff_t, IsSimdPartitionable<T, Comp>::value ? (1 << 14) : (1 << 7)> {};
+
+/// сортирует k = middle - first наименьших элементов и ставит их в [first, middle), порядок остальных не определен.
+/// при k намного меньше n - проход с ограниченной кучей (O(n + k log k log(n / k))), иначе разбиение mynth_element
+/// вокруг k-го элемента и сортировка префикса
+template <typename T, typename Comp>
+void mypartial_sort(T first, T middle, T last, Comp comp) {
+    const std::ptrdiff_t heapRatio = PartialSortHeapRatio<T, Comp>::value;
+
+    auto n = std::distance(first, last);
+    auto k = std::distance(first, middle);
+    if (k == 0) {
+        return;
+    }
+    if (k * heapRatio <= n) {
+        heapSelectSort(first, middle, last, comp);
+        return;
+    }
+    if (middle == last) {
+        mysort(first, last, comp);
+        return;
+    }
+    mynth_element(first, middle - 1, last, comp);
+    mysort(first, middle - 1, comp);
+}
+
+/// American flag sort: раскладывает [first, last) по корзинам байта ключа на позиции shift перестановкой
+/// по циклам без дополнительной памяти и рекурсивно сортирует корзины по следующему байту;
+/// маленькие корзины досортировываются mysort
+template <typename T, typename KeyFn>
+void msdRadixSortImpl(T first, T last, KeyFn key, int shift) {
+    const std::ptrdiff_t fallbackSize = 64;
+
+    auto digit = [&key, &shift](const auto& value) { return static_cast<int>((key(value) >> shift) & 0xff); };
+    std::ptrdiff_t counts[256];
+    while (true) {
+        auto n = std::distance(first, last);
+        if (n <= fallbackSize) {
+            mysort(first, last, [&key](const auto& a, const auto& b) { return key(a) < key(b); });
+            return;
+        }
+
+        std::fill(std::begin(counts), std::end(counts), 0);
+        for (auto iter = first; iter != last; ++iter) {
+            ++counts[digit(*iter)];
+        }
+        if (std::find(std::begin(counts), std::end(counts), n) == std::end(counts)) {
+            break;
+        }
+        // у всех элементов этот байт одинаков
+        if (shift == 0) {
+            return;
+        }
+        shift -= 8;
+    }
+
+    std::ptrdiff_t heads[256];
+    std::ptrdiff_t ends[256];
+    std::ptrdiff_t sum = 0;
+    for (int b = 0; b < 256; ++b) {
+        heads[b] = sum;
+        sum += counts[b];
+        ends[b] = sum;
+    }
+
+    for (int b = 0; b < 256; ++b) {
+        while (heads[b] < ends[b]) {
+            auto value = std::move(first[heads[b]]);
+            auto d = digit(value);
+            while (d != b) {
+                std::swap(value, first[heads[d]++]);
+                d = digit(value);
+            }
+            first[heads[b]++] = std::move(value);
+        }
+    }
+
+    if (shift == 0) {
+        return;
+    }
+    std::ptrdiff_t begin = 0;
+    for (int b = 0; b < 256; ++b) {
+        if (counts[b] > 1) {
+            msdRadixSortImpl(first + begin, first + begin + counts[b], key, shift - 8);
+        }
+        begin += counts[b];
+    }
+}
+
+/// поразрядная сортировка на месте по ключу фиксированной ширины: key возвращает беззнаковое целое,
+/// элементы упорядочиваются по его возрастанию
+template <typename T, typename KeyFn>
+void mymsd_radix_sort_by_key(T first, T last, KeyFn key) {
+    using Key = std::decay_t<decltype(key(*first))>;
+    static_assert(std::is_unsigned<Key>::value, "key must be an unsigned integer");
+    if (std::distance(first, last) < 2) {
+        return;
+    }
+    msdRadixSortImpl(first, last, key, 8 * (static_cast<int>(sizeof(Key)) - 1));
+}
+
+/// поразрядная сортировка на месте для целых и чисел с плавающей точкой при сравнении std::less или std::greater
+template <typename T, typename Comp>
+void mymsd_radix_sort(T first, T last, [[maybe_unused]] Comp comp) {
+    using V = typename std::iterator_traits<T>::value_type;
+    using Key = typename RadixKey<V>::Key;
+    static_assert(RadixOrder<Comp, V>::value != 0, "comparator must be std::less or std::greater");
+    const Key orderMask = RadixOrder<Comp, V>::value < 0 ? static_cast<Key>(~Key(0)) : Key(0);
+    mymsd_radix_sort_by_key(first, last, [orderMask](const V& value) {
+        return static_cast<Key>(RadixKey<V>::toKey(value) ^ orderMask);
+    });
+}
+
+/// массивы фиксированного размера сортируются сетью, построенной на этапе компиляции, без проверок размера и циклов
+template <typename V, std::size_t N, typename Comp = std::less<V>>
+constexpr void mysort(std::array<V, N>& values, Comp comp = Comp()) {
+    sort_n<N>(values.begin(), comp);
+}
+
+/// устойчивая сортировка вставками, место вставки ищется бинарным поиском
+template <typename T, typename Comp>
+void binaryInsertionSort(T first, T last, Comp comp) {
+    if (first == last) {
+        return;
+    }
+    for (T i = first + 1; i != last; ++i) {
+        T position = std::upper_bound(first, i, *i, comp);
+        if (position != i) {
+            auto val = std::move(*i);
+            std::move_backward(position, i, i + 1);
+            *position = std::move(val);
+        }
+    }
+}
+
+/// первый элемент [first, last), больший key: экспоненциальный поиск от first, затем бинарный.
+/// дешевле upper_bound, когда ответ близко к first
+template <typename T, typename V, typename Comp>
+T gallopUpperBound(T first, T last, const V& key, Comp comp) {
+    auto n = std::distance(first, last);
+    std::ptrdiff_t lo = 0;
+    std::ptrdiff_t hi = 1;
+    while (hi < n && !comp(key, first[hi - 1])) {
+        lo = hi;
+        hi = 2 * hi + 1;
+    }
+    return std::upper_bound(first + lo, first + std::min(hi, n), key, comp);
+}
+
+/// первый элемент [first, last), не меньший key, тем же поиском
+template <typename T, typename V, typename Comp>
+T gallopLowerBound(T first, T last, const V& key, Comp comp) {
+    auto n = std::distance(first, last);
+    std::ptrdiff_t lo = 0;
+    std::ptrdiff_t hi = 1;
+    while (hi < n && comp(first[hi - 1], key)) {
+        lo = hi;
+        hi = 2 * hi + 1;
+    }
+    return std::lower_bound(first + lo, first + std::min(hi, n), key, comp);
+}
+
+/// слияние с галопом (как в TimSort) отрезков [left, leftEnd) и [right, rightEnd) в out, при равенстве первым идет
+/// элемент левого отрезка. пока один отрезок не выиграл minGallop раз подряд, элементы переносятся по одному,
+/// затем отрезки переносятся кусками, найденными галопом. minGallop подстраивается под данные: уменьшается,
+/// пока галоп окупается, и растет, когда нет. остаток правого отрезка не переносится: возвращаются его начало
+/// и место, куда он должен попасть (при слиянии на месте они совпадают)
+template <typename B, typename T, typename Out, typename Comp>
+std::pair<T, Out> gallopMerge(B left, B leftEnd, T right, T rightEnd, Out out, Comp comp, int& minGallop) {
+    const int gallopWin = 7;
+
+    while (left != leftEnd && right != rightEnd) {
+        int leftWins = 0;
+        int rightWins = 0;
+        while (left != leftEnd && right != rightEnd) {
+            if (comp(*right, *left)) {
+                *out++ = std::move(*right++);
+                leftWins = 0;
+                if (++rightWins >= minGallop) {
+                    break;
+                }
+            } else {
+                *out++ = std::move(*left++);
+                rightWins = 0;
+                if (++leftWins >= minGallop) {
+                    break;
+                }
+            }
+        }
+
+        while (left != leftEnd && right != rightEnd) {
+            B leftStop = gallopUpperBound(left, leftEnd, *right, comp);
+            auto leftCount = std::distance(left, leftStop);
+            out = std::move(left, leftStop, out);
+            left = leftStop;
+            if (left == leftEnd) {
+                break;
+            }
+            *out++ = std::move(*right++);
+            if (right == rightEnd) {
+                break;
+            }
+
+            T rightStop = gallopLowerBound(right, rightEnd, *left, comp);
+            auto rightCount = std::distance(right, rightStop);
+            out = std::move(right, rightStop, out);
+            right = rightStop;
+            if (right == rightEnd) {
+                break;
+            }
+            *out++ = std::move(*left++);
+
+            if (minGallop > 1) {
+                --minGallop;
+            }
+            if (leftCount < gallopWin && rightCount < gallopWin) {
+                minGallop += 2;
+                break;
+            }
+        }
+    }
+    return {right, std::move(left, leftEnd, out)};
+}
+
+/// один уровень восходящей сортировки слиянием: соседние отрезки длины width из src сливаются в dst.
+/// уже упорядоченные пары просто переносятся
+template <typename S, typename D, typename Comp>
+void mergeLevel(S src, std::ptrdiff_t n, std::ptrdiff_t width, D dst, Comp comp, int& minGallop) {
+    for (std::ptrdiff_t start = 0; start < n; start += 2 * width) {
+        auto middle = std::min(start + width, n);
+        auto end = std::min(start + 2 * width, n);
+        if (middle == end || !comp(src[middle], src[middle - 1])) {
+            std::move(src + start, src + end, dst + start);
+        } else {
+            auto rest = gallopMerge(src + start, src + middle, src + middle, src + end, dst + start, comp, minGallop);
+            std::move(rest.first, src + end, rest.second);
+        }
+    }
+}
+
+/// доращивает буфер слияний до size элементов, не требуя конструктора по умолчанию: новый элемент создается
+/// перемещением из [first, first + size), и значение сразу возвращается на место
+template <typename T, typename V>
+void growMergeBuffer(std::vector<V>& buffer, T first, std::size_t size) {
+    if (buffer.size() >= size) {
+        return;
+    }
+    buffer.reserve(size);
+    for (auto i = static_cast<std::ptrdiff_t>(buffer.size()); buffer.size() < size; ++i) {
+        buffer.push_back(std::move(first[i]));
+        first[i] = std::move(buffer.back());
+    }
+}
+
+/// устойчивая сортировка: восходящая сортировка слиянием. отрезки по 32 элемента сортируются бинарными вставками,
+/// затем сливаются попарно с галопом, поочередно из массива в буфер и обратно, так что каждый уровень переносит
+/// каждый элемент один раз. buffer - переиспользуемая память для слияний на n элементов
+template <typename T, typename Comp, typename V = typename std::iterator_traits<T>::value_type>
+void mystable_sort(T first, T last, Comp comp, std::vector<V>& buffer) {
+    const std::ptrdiff_t runSize = 32;
+
+    auto n = std::distance(first, last);
+    if (n < 2) {
+        return;
+    }
+    for (std::ptrdiff_t start = 0; start < n; start += runSize) {
+        binaryInsertionSort(first + start, first + std::min(start + runSize, n), comp);
+    }
+    if (n <= runSize) {
+        return;
+    }
+    growMergeBuffer(buffer, first, static_cast<std::size_t>(n));
+
+    int minGallop = 7;
+    bool inBuffer = false;
+    for (std::ptrdiff_t width = runSize; width < n; width *= 2) {
+        if (inBuffer) {
+            mergeLevel(buffer.begin(), n, width, first, comp, minGallop);
+        } else {
+            mergeLevel(first, n, width, buffer.begin(), comp, minGallop);
+        }
+        inBuffer = !inBuffer;
+    }
+    if (inBuffer) {
+        std::move(buffer.begin(), buffer.begin() + n, first);
+    }
+}
+
+template <typename T, typename Comp>
+void mystable_sort(T first, T last, Comp comp) {
+    std::vector<typename std::iterator_traits<T>::value_type> buffer;
+    mystable_sort(first, last, comp, buffer);
+}
+
+/// устойчивое слияние без дополнительной памяти: больший отрезок делится пополам, парная точка во втором ищется
+/// бинарным поиском, средние части меняются поворотом. O(n log n) перемещений на слияние
+template <typename T, typename Comp>
+void rotationMerge(T first, T middle, T last, Comp comp) {
+    while (first != middle && middle != last) {
+        auto leftSize = std::distance(first, middle);
+        auto rightSize = std::distance(middle, last);
+        if (leftSize + rightSize == 2) {
+            if (comp(*middle, *first)) {
+                std::iter_swap(first, middle);
+            }
+            return;
+        }
+        T leftCut;
+        T rightCut;
+        if (leftSize > rightSize) {
+            leftCut = first + leftSize / 2;
+            rightCut = std::lower_bound(middle, last, *leftCut, comp);
+        } else {
+            rightCut = middle + rightSize / 2;
+            leftCut = std::upper_bound(first, middle, *rightCut, comp);
+        }
+        T newMiddle = std::rotate(leftCut, middle, rightCut);
+        rotationMerge(first, leftCut, newMiddle, comp);
+        first = newMiddle;
+        middle = rightCut;
+    }
+}
+
+/// восходящая сортировка слиянием на rotationMerge: O(n log^2 n), но без буфера
+template <typename T, typename Comp>
+void rotationMergeSort(T first, T last, Comp comp) {
+    const std::ptrdiff_t runSize = 16;
+
+    auto n = std::distance(first, last);
+    for (std::ptrdiff_t start = 0; start < n; start += runSize) {
+        binaryInsertionSort(first + start, first + std::min(start + runSize, n), comp);
+    }
+    for (std::ptrdiff_t width = runSize; width < n; width *= 2) {
+        for (std::ptrdiff_t start = 0; start + width < n; start += 2 * width) {
+            rotationMerge(first + start, first + start + width, first + std::min(start + 2 * width, n), comp);
+        }
+    }
+}
+
+/// собирает в начало [first, last) до wanted попарно различных элементов (первые вхождения), упорядоченных
+/// по возрастанию, не меняя порядок остальных. блок ключей перекатывается поворотами к следующему новому ключу.
+/// возвращает число собранных ключей
+template <typename T, typename Comp>
+std::ptrdiff_t collectKeys(T first, T last, std::ptrdiff_t wanted, Comp comp) {
+    if (first == last) {
+        return 0;
+    }
+    T keys = first;
+    std::ptrdiff_t count = 1;
+    for (T iter = first + 1; iter != last && count < wanted; ++iter) {
+        T position = std::lower_bound(keys, keys + count, *iter, comp);
+        if (position != keys + count && !comp(*iter, *position)) {
+            continue;
+        }
+        auto offset = std::distance(keys, position);
+        std::rotate(keys, keys + count, iter);
+        keys = iter - count;
+        std::rotate(keys + offset, iter, iter + 1);
+        ++count;
+    }
+    std::rotate(first, keys, keys + count);
+    return count;
+}
+
+/// сливает [first, middle) и [middle, last) обменами с внутренним буфером: левый отрезок (не длиннее буфера)
+/// меняется местами с буфером и сливается обратно. содержимое буфера переставляется, но сохраняется
+template <typename T, typename Comp>
+void bufferMergeLeft(T buffer, T first, T middle, T last, Comp comp) {
+    T left = buffer;
+    T leftEnd = std::swap_ranges(first, middle, buffer);
+    T right = middle;
+    T out = first;
+    while (left != leftEnd && right != last) {
+        if (comp(*right, *left)) {
+            std::iter_swap(out++, right++);
+        } else {
+            std::iter_swap(out++, left++);
+        }
+    }
+    std::swap_ranges(left, leftEnd, out);
+}
+
+/// то же, но в буфер выносится правый отрезок и слияние идет с конца
+template <typename T, typename Comp>
+void bufferMergeRight(T buffer, T first, T middle, T last, Comp comp) {
+    T rightEnd = std::swap_ranges(middle, last, buffer);
+    T left = middle;
+    T out = last;
+    while (left != first && rightEnd != buffer) {
+        if (comp(*(rightEnd - 1), *(left - 1))) {
+            std::iter_swap(--out, --left);
+        } else {
+            std::iter_swap(--out, --rightEnd);
+        }
+    }
+    while (rightEnd != buffer) {
+        std::iter_swap(--out, --rightEnd);
+    }
+}
+
+/// локальное слияние блочного слияния: pending = [first, middle) - еще не поставленный на место остаток из отрезка
+/// pendingFromA, [middle, last) - следующий блок из другого отрезка. слияние идет, пока не кончится один из них;
+/// возвращает начало нового остатка и обновляет pendingFromA. при равенстве первым идет элемент из A
+template <typename T, typename Comp>
+T blockLocalMerge(T buffer, T first, T middle, T last, Comp comp, bool& pendingFromA) {
+    T left = buffer;
+    T leftEnd = std::swap_ranges(first, middle, buffer);
+    T right = middle;
+    T out = first;
+    while (left != leftEnd && right != last) {
+        bool takeRight = pendingFromA ? comp(*right, *left) : !comp(*left, *right);
+        if (takeRight) {
+            std::iter_swap(out++, right++);
+        } else {
+            std::iter_swap(out++, left++);
+        }
+    }
+    if (left == leftEnd) {
+        // остаток блока уже на своем месте и становится новым остатком
+        pendingFromA = !pendingFromA;
+        return right;
+    }
+    std::swap_ranges(left, leftEnd, out);
+    return out;
+}
+
+/// блочное слияние (Kim, Kutzner; GrailSort): |A| = [first, middle) кратна blockSize, B = [middle, last) - целые блоки
+/// и неполный хвост. целые блоки помечаются ключами tags и сортируются выбором по (первый элемент, ключ), после
+/// чего соседние блоки из разных отрезков сливаются локально через буфер из blockSize элементов. хвост B
+/// вливается в конце. ключи после сортировки блоков возвращаются в исходный порядок
+template <typename T, typename Comp>
+void blockMerge(T tags, T buffer, std::ptrdiff_t blockSize, T first, T middle, T last, Comp comp) {
+    if (!comp(*middle, *(middle - 1))) {
+        return;
+    }
+    auto tail = std::distance(middle, last) % blockSize;
+    T blocksEnd = last - tail;
+    auto blocks = std::distance(first, blocksEnd) / blockSize;
+    auto midTag = std::distance(first, middle) / blockSize;
+
+    for (std::ptrdiff_t i = 0; i < blocks; ++i) {
+        auto min = i;
+        for (auto j = i + 1; j < blocks; ++j) {
+            const auto& candidate = first[j * blockSize];
+            const auto& best = first[min * blockSize];
+            if (comp(candidate, best) || (!comp(best, candidate) && comp(tags[j], tags[min]))) {
+                min = j;
+            }
+        }
+        if (min != i) {
+            std::swap_ranges(first + i * blockSize, first + (i + 1) * blockSize, first + min * blockSize);
+            std::iter_swap(tags + i, tags + min);
+            if (midTag == i) {
+                midTag = min;
+            } else if (midTag == min) {
+                midTag = i;
+            }
+        }
+    }
+
+    if (blocks > 0) {
+        T pending = first;
+        bool pendingFromA = comp(tags[0], tags[midTag]);
+        for (std::ptrdiff_t j = 1; j < blocks; ++j) {
+            T block = first + j * blockSize;
+            bool blockFromA = comp(tags[j], tags[midTag]);
+            if (blockFromA == pendingFromA) {
+                pending = block;
+            } else {
+                pending = blockLocalMerge(buffer, pending, block, block + blockSize, comp, pendingFromA);
+            }
+        }
+        heapSort(tags, tags + blocks, comp);
+    }
+    if (tail > 0) {
+        bufferMergeRight(buffer, first, blocksEnd, last, comp);
+    }
+}
+
+/// устойчивая сортировка без выделения памяти (блочная сортировка слиянием в духе GrailSort). в начало массива
+/// собираются blockSize + n / blockSize различных ключей, blockSize ~ sqrt(n): первые blockSize служат буфером
+/// для слияния обменами, остальные - метками блоков. отрезки не длиннее буфера сливаются через буфер, более
+/// длинные - блочным слиянием. в конце ключи сортируются и вливаются обратно поворотами. если различных
+/// элементов не хватает, массив сортируется слиянием на поворотах за O(n log^2 n)
+template <typename T, typename Comp>
+void myinplace_stable_sort(T first, T last, Comp comp) {
+    const std::ptrdiff_t runSize = 16;
+    const std::ptrdiff_t insertionSortSize = 256;
+
+    auto n = std::distance(first, last);
+    if (n <= insertionSortSize) {
+        binaryInsertionSort(first, last, comp);
+        return;
+    }
+
+    std::ptrdiff_t blockSize = runSize;
+    while (4 * blockSize * blockSize <= n) {
+        blockSize *= 2;
+    }
+    auto wantedKeys = blockSize + (n + blockSize - 1) / blockSize;
+    auto keyCount = collectKeys(first, last, wantedKeys, comp);
+    T rest = first + keyCount;
+    if (keyCount < wantedKeys) {
+        rotationMergeSort(rest, last, comp);
+        rotationMerge(first, rest, last, comp);
+        return;
+    }
+
+    T buffer = first;
+    T tags = first + blockSize;
+    auto restSize = std::distance(rest, last);
+    for (std::ptrdiff_t start = 0; start < restSize; start += runSize) {
+        binaryInsertionSort(rest + start, rest + std::min(start + runSize, restSize), comp);
+    }
+    for (std::ptrdiff_t width = runSize; width < restSize; width *= 2) {
+        for (std::ptrdiff_t start = 0; start + width < restSize; start += 2 * width) {
+            T middle = rest + start + width;
+            T end = rest + std::min(start + 2 * width, restSize);
+            if (width <= blockSize) {
+                if (comp(*middle, *(middle - 1))) {
+                    bufferMergeLeft(buffer, rest + start, middle, end, comp);
+                }
+            } else {
+                blockMerge(tags, buffer, blockSize, rest + start, middle, end, comp);
+            }
+        }
+    }
+
+    // ключи попарно различны, поэтому неустойчивая сортировка восстанавливает их единственный порядок
+    heapSort(first, rest, comp);
+    rotationMerge(first, rest, last, comp);
+}
+
+/// сливает соседние отсортированные отрезки [first, middle) и [middle, last) на месте. префикс левого и суффикс
+/// правого, которые уже стоят на своих местах, отбрасываются галопом, в буфер выносится меньший из оставшихся
+/// отрезков. если выносится правый, слияние идет с конца: по обратным итераторам с перевернутым компаратором
+template <typename T, typename Comp, typename V = typename std::iterator_traits<T>::value_type>
+void mergeRuns(T first, T middle, T last, Comp comp, std::vector<V>& buffer, int& minGallop) {
+    if (first == middle || middle == last || !comp(*middle, *(middle - 1))) {
+        return;
+    }
+    first = gallopUpperBound(first, middle, *middle, comp);
+    last = gallopLowerBound(middle, last, *(middle - 1), comp);
+
+    auto leftSize = std::distance(first, middle);
+    auto rightSize = std::distance(middle, last);
+    auto bufferSize = static_cast<std::size_t>(std::min(leftSize, rightSize));
+    growMergeBuffer(buffer, first, bufferSize);
+
+    if (leftSize <= rightSize) {
+        auto bufferEnd = std::move(first, middle, buffer.begin());
+        gallopMerge(buffer.begin(), bufferEnd, middle, last, first, comp, minGallop);
+    } else {
+        auto bufferEnd = std::move(middle, last, buffer.begin());
+        using RT = std::reverse_iterator<T>;
+        using RB = std::reverse_iterator<typename std::vector<V>::iterator>;
+        gallopMerge(RB(bufferEnd), RB(buffer.begin()), RT(middle), RT(first), RT(last),
+                    [&comp](const V& a, const V& b) { return comp(b, a); }, minGallop);
+    }
+}
+
+/// длина естественного отрезка, начинающегося в first: неубывающего или строго убывающего. строго убывающий
+/// разворачивается - равных элементов в нем нет, поэтому разворот не нарушает устойчивость
+template <typename T, typename Comp>
+std::ptrdiff_t naturalRun(T first, T last, Comp comp) {
+    T end = first + 1;
+    if (end == last) {
+        return 1;
+    }
+    if (comp(*end, *first)) {
+        while (end + 1 != last && comp(*(end + 1), *end)) {
+            ++end;
+        }
+        ++end;
+        std::reverse(first, end);
+    } else {
+        while (end + 1 != last && !comp(*(end + 1), *end)) {
+            ++end;
+        }
+        ++end;
+    }
+    return std::distance(first, end);
+}
+
+/// минимальная длина отрезка (как в TimSort): от 32 до 64, причем n / minRun близко к степени двойки снизу,
+/// чтобы слияния были сбалансированными
+inline std::ptrdiff_t timsortMinRun(std::ptrdiff_t n) {
+    std::ptrdiff_t low = 0;
+    while (n >= 64) {
+        low |= n & 1;
+        n >>= 1;
+    }
+    return n + low;
+}
+
+/// приоритет границы между соседними отрезками [s1, s1 + n1) и [s1 + n1, s1 + n1 + n2) в powersort (Munro, Wild.
+/// Nearly-Optimal Mergesorts): номер первого бита, в котором различаются двоичные дроби середин отрезков,
+/// деленных на n. отрезки с большим приоритетом сливаются раньше
+inline int powersortPower(std::ptrdiff_t s1, std::ptrdiff_t n1, std::ptrdiff_t n2, std::ptrdiff_t n) {
+    int power = 0;
+    auto a = 2 * s1 + n1;
+    auto b = a + n1 + n2;
+    while (true) {
+        ++power;
+        if (a >= n) {
+            a -= n;
+            b -= n;
+        } else if (b >= n) {
+            break;
+        }
+        a <<= 1;
+        b <<= 1;
+    }
+    return power;
+}
+
+/// адаптивная устойчивая сортировка: массив разбивается на естественные отрезки (убывающие разворачиваются),
+/// короткие дополняются бинарными вставками до minRun. отрезки лежат на стеке с возрастающими приоритетами границ
+/// (powersort), новая граница сначала сливает все отрезки над границами с большим приоритетом. слияния - mergeRuns
+/// с галопом. на уже отсортированных и почти отсортированных данных работает за время, близкое к линейному
+template <typename T, typename Comp>
+void mytimsort(T first, T last, Comp comp) {
+    struct Run {
+        std::ptrdiff_t start;
+        std::ptrdiff_t length;
+        int power;
+    };
+
+    auto n = std::distance(first, last);
+    if (n < 2) {
+        return;
+    }
+    auto minRun = timsortMinRun(n);
+    std::vector<typename std::iterator_traits<T>::value_type> buffer;
+    int minGallop = 7;
+
+    // приоритеты на стеке строго возрастают и не больше разрядности n, поэтому стек ограничен
+    Run stack[2 * sizeof(std::ptrdiff_t) * 8 + 2];
+    int top = 0;
+    auto mergeTop = [&] {
+        Run& left = stack[top - 2];
+        const Run& right = stack[top - 1];
+        mergeRuns(first + left.start, first + right.start, first + right.start + right.length, comp, buffer,
+                  minGallop);
+        left.length += right.length;
+        --top;
+    };
+
+    for (std::ptrdiff_t start = 0; start < n;) {
+        auto length = naturalRun(first + start, last, comp);
+        if (length < minRun) {
+            length = std::min(minRun, n - start);
+            binaryInsertionSort(first + start, first + start + length, comp);
+        }
+        if (top > 0) {
+            int power = powersortPower(stack[top - 1].start, stack[top - 1].length, length, n);
+            while (top > 1 && stack[top - 2].power > power) {
+                mergeTop();
+            }
+            stack[top - 1].power = power;
+        }
+        stack[top++] = {start, length, 0};
+        start += length;
+    }
+    while (top > 1) {
+        mergeTop();
+    }
+}
+
+template <typename K, typename Index = std::size_t>
+struct KeyIndex {
+    K key;
+    Index index;
+};
+
+/// устойчиво сортирует пары (ключ, индекс) по ключу: ключи, для которых есть RadixKey, - поразрядной сортировкой
+template <typename K, typename Index>
+void sortKeyIndex(std::vector<KeyIndex<K, Index>>& entries) {
+    const std::size_t radixSortThreshold = 256;
+
+    if constexpr (RadixKey<K>::supported) {
+        if (entries.size() >= radixSortThreshold) {
+            lsdRadixSortByKey(entries.begin(), entries.end(),
+                              [](const KeyIndex<K, Index>& entry) { return stableRadixKey(entry.key); });
+            return;
+        }
+    }
+    mysort(entries.begin(), entries.end(), [](const KeyIndex<K, Index>& a, const KeyIndex<K, Index>& b) {
+        return a.key < b.key || (!(b.key < a.key) && a.index < b.index);
+    });
+}
+
+template <typename Index>
+void checkIndexRange(std::ptrdiff_t n) {
+    if (static_cast<std::uint64_t>(n) > static_cast<std::uint64_t>(std::numeric_limits<Index>::max())) {
+        throw std::length_error("range is too long for the index type");
+    }
+}
+
+/// устойчивая сортировка индексов по возрастанию keyFn(x): ключ каждого элемента вычисляется один раз,
+/// и сравниваются ключи, лежащие подряд в памяти. order[i] - исходный индекс элемента, который должен стоять
+/// на i-м месте
+template <typename Index = std::uint32_t, typename T, typename KeyFn>
+std::vector<Index> myargsort_by_key(T first, T last, KeyFn keyFn) {
+    using K = std::decay_t<decltype(keyFn(*first))>;
+    static_assert(std::is_unsigned<Index>::value, "index must be an unsigned integer");
+
+    auto n = std::distance(first, last);
+    checkIndexRange<Index>(n);
+    std::vector<KeyIndex<K, Index>> entries;
+    entries.reserve(n);
+    Index index = 0;
+    for (auto iter = first; iter != last; ++iter) {
+        entries.push_back({keyFn(*iter), index++});
+    }
+    sortKeyIndex(entries);
+
+    std::vector<Index> order;
+    order.reserve(n);
+    for (auto& entry : entries) {
+        order.push_back(entry.index);
+    }
+    return order;
+}
+
+/// устойчивая сортировка индексов по компаратору. при std::less / std::greater для чисел сортируются ключи RadixKey,
+/// тривиально копируемые значения копируются в массив пар (значение, индекс), и только для остальных типов
+/// компаратор обращается к элементам по индексам
+template <typename Index = std::uint32_t, typename T, typename Comp>
+std::vector<Index> myargsort(T first, T last, Comp comp) {
+    using V = typename std::iterator_traits<T>::value_type;
+    static_assert(std::is_unsigned<Index>::value, "index must be an unsigned integer");
+
+    if constexpr (RadixKey<V>::supported && RadixOrder<Comp, V>::value != 0) {
+        using Key = typename RadixKey<V>::Key;
+        const Key orderMask = RadixOrder<Comp, V>::value < 0 ? static_cast<Key>(~Key(0)) : Key(0);
+        return myargsort_by_key<Index>(first, last, [orderMask](const V& value) {
+            return static_cast<Key>(stableRadixKey(value) ^ orderMask);
+        });
+    } else if constexpr (std::is_trivially_copyable<V>::value) {
+        auto n = std::distance(first, last);
+        checkIndexRange<Index>(n);
+        std::vector<KeyIndex<V, Index>> entries;
+        entries.reserve(n);
+        Index index = 0;
+        for (auto iter = first; iter != last; ++iter) {
+            entries.push_back({*iter, index++});
+        }
+        mysort(entries.begin(), entries.end(), [&comp](const KeyIndex<V, Index>& a, const KeyIndex<V, Index>& b) {
+            return comp(a.key, b.key) || (!comp(b.key, a.key) && a.index < b.index);
+        });
+
+        std::vector<Index> order;
+        order.reserve(n);
+        for (auto& entry : entries) {
+            order.push_back(entry.index);
+        }
+        return order;
+    } else {
+        auto n = std::distance(first, last);
+        checkIndexRange<Index>(n);
+        std::vector<Index> order(n);
+        for (std::ptrdiff_t i = 0; i < n; ++i) {
+            order[i] = static_cast<Index>(i);
+        }
+        mysort(order.begin(), order.end(), [&comp, first](Index a, Index b) {
+            return comp(first[a], first[b]) || (!comp(first[b], first[a]) && a < b);
+        });
+        return order;
+    }
+}
+
+/// переставляет элементы так, что на i-е место встает элемент с индексом order[i]. перестановка обходится
+/// по циклам: каждый элемент перемещается один раз, на каждый цикл нужен один временный элемент
+template <typename Index, typename T>
+void applyPermutationCycles(const std::vector<Index>& order, T first, std::vector<bool>& done) {
+    std::fill(done.begin(), done.end(), false);
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        if (done[i] || static_cast<std::size_t>(order[i]) == i) {
+            continue;
+        }
+        auto saved = std::move(first[i]);
+        auto j = i;
+        for (auto k = static_cast<std::size_t>(order[j]); k != i; k = static_cast<std::size_t>(order[j])) {
+            first[j] = std::move(first[k]);
+            done[j] = true;
+            j = k;
+        }
+        first[j] = std::move(saved);
+        done[j] = true;
+    }
+}
+
+/// применяет перестановку order (например, результат myargsort) ко всем переданным диапазонам сразу,
+/// каждый диапазон задается началом и должен содержать не меньше order.size() элементов
+template <typename Index, typename... T>
+void myapply_permutation(const std::vector<Index>& order, T... firsts) {
+    std::vector<bool> done(order.size());
+    (applyPermutationCycles(order, firsts, done), ...);
+}
+
+/// сортирует [first, last) по возрастанию keyFn(x), вычисляя ключ каждого элемента один раз. сортировка устойчива.
+/// возвращает порядок, как myargsort_by_key; при permute == false сами элементы не переставляются
+template <typename T, typename KeyFn>
+std::vector<std::size_t> mysort_by_key(T first, T last, KeyFn keyFn, bool permute = true) {
+    auto order = myargsort_by_key<std::size_t>(first, last, keyFn);
+    if (permute) {
+        myapply_permutation(order, first);
+    }
+    return order;
+}
+
+template <typename T, typename Comp>
+void parallelSortLoop(T first, T last, Comp comp, int depthLimit, bool leftmost, std::ptrdiff_t cutoff,
+                      ThreadPool& pool, TaskGroup& group) {
+    // верхние уровни рекурсии разбиваются параллельно, иначе первые проходы по всему массиву идут на одном ядре
+    const std::ptrdiff_t parallelPartitionCutoff = 1 << 17;
+
+    DefaultPartition partition;
+    DefaultPivot pivotPolicy;
+    while (std::distance(first, last) > cutoff) {
+        if (depthLimit == 0) {
+            heapSort(first, last, comp);
+            return;
+        }
+        --depthLimit;
+
+        std::pair<T, T> bounds;
+        if (pool.size() > 1 && std::distance(first, last) >= parallelPartitionCutoff) {
+            ParallelPartition parallelPartition{pool};
+            bounds = introPartition(first, last, comp, leftmost, parallelPartition, pivotPolicy);
+        } else {
+            bounds = introPartition(first, last, comp, leftmost, partition, pivotPolicy);
+        }
+        T leftEnd = bounds.first;
+        T rightBegin = bounds.second;
+
+        // меньшая часть уходит в пул, большая обрабатывается дальше в этом потоке
+        if (std::distance(first, leftEnd) < std::distance(rightBegin, last)) {
+            group.run([=, &pool, &group] {
+                parallelSortLoop(first, leftEnd, comp, depthLimit, leftmost, cutoff, pool, group);
+            });
+            first = rightBegin;
+            leftmost = false;
+        } else {
+            group.run([=, &pool, &group] {
+                parallelSortLoop(rightBegin, last, comp, depthLimit, false, cutoff, pool, group);
+            });
+            last = leftEnd;
+        }
+    }
+    introSort(first, last, comp, depthLimit, leftmost, partition, pivotPolicy);
+}
+
+/// параллельный mysort: после каждого разбиения отрезка длиннее cutoff одна из частей отдается пулу потоков,
+/// отрезки не длиннее cutoff сортируются последовательно
+template <typename T, typename Comp>
+void myparallel_sort(T first, T last, Comp comp, ThreadPool& pool, std::ptrdiff_t cutoff = 1 << 14) {
+    auto n = std::distance(first, last);
+    if (n < 2) {
+        return;
+    }
+    TaskGroup group(pool);
+    parallelSortLoop(first, last, comp, 2 * floorLog2(n), true, std::max<std::ptrdiff_t>(cutoff, 8), pool, group);
+    group.wait();
+}
+
+template <typename T, typename Comp>
+void myparallel_sort(T first, T last, Comp comp) {
+    myparallel_sort(first, last, comp, defaultThreadPool());
+}
+
+/// раскладка через буферы на каждую корзину (программное write-combining): элементы копятся по строке кэша
+/// на корзину и переносятся в out целиком, поэтому запись не разбрасывается по 256 адресам одновременно
+template <typename Src, typename Dst, typename KeyFn>
+void radixScatterBuffered(Src first, Src last, Dst out, KeyFn key, int shift, std::ptrdiff_t* offsets) {
+    using V = typename std::iterator_traits<Src>::value_type;
+    const std::ptrdiff_t width = sizeof(V) < 64 ? 64 / sizeof(V) : 1;
+
+    std::vector<V> staging(256 * width);
+    std::ptrdiff_t filled[256] = {};
+    for (; first != last; ++first) {
+        auto digit = (key(*first) >> shift) & 0xff;
+        auto slot = staging.begin() + digit * width;
+        slot[filled[digit]++] = std::move(*first);
+        if (filled[digit] == width) {
+            std::move(slot, slot + width, out + offsets[digit]);
+            offsets[digit] += width;
+            filled[digit] = 0;
+        }
+    }
+    for (int digit = 0; digit < 256; ++digit) {
+        auto slot = staging.begin() + digit * width;
+        std::move(slot, slot + filled[digit], out + offsets[digit]);
+    }
+}
+
+/// параллельная LSD поразрядная сортировка: массив делится на куски по числу потоков пула. на каждом разряде
+/// каждый кусок строит свою гистограмму, из них складываются глобальные смещения (корзина за корзиной,
+/// внутри корзины - кусок за куском), и куски раскладываются одновременно в непересекающиеся позиции
+template <typename T, typename Comp>
+void parallelRadixSortImpl(T first, T last, Comp comp, ThreadPool& pool) {
+    using V = typename std::iterator_traits<T>::value_type;
+    using Key = typename RadixKey<V>::Key;
+    using Counts = std::array<std::ptrdiff_t, 256>;
+    const int digits = sizeof(Key);
+    const std::ptrdiff_t sequentialCutoff = 1 << 16;
+    const Key orderMask = RadixOrder<Comp, V>::value < 0 ? static_cast<Key>(~Key(0)) : Key(0);
+    auto key = [orderMask](const V& value) { return static_cast<Key>(RadixKey<V>::toKey(value) ^ orderMask); };
+
+    auto n = std::distance(first, last);
+    if (pool.size() < 2 || n < sequentialCutoff) {
+        myradix_sort(first, last, comp);
+        return;
+    }
+
+    auto chunks = static_cast<std::ptrdiff_t>(pool.size());
+    auto chunkBegin = [n, chunks](std::ptrdiff_t chunk) { return n * chunk / chunks; };
+    auto forEachChunk = [&pool, chunks](auto f) {
+        TaskGroup group(pool);
+        for (std::ptrdiff_t chunk = 0; chunk < chunks; ++chunk) {
+            group.run([f, chunk] { f(chunk); });
+        }
+        group.wait();
+    };
+
+    // гистограммы всех разрядов за один проход; для первого разряда они же - гистограммы кусков
+    std::vector<std::vector<Counts>> chunkCounts(chunks, std::vector<Counts>(digits));
+    forEachChunk([&](std::ptrdiff_t chunk) {
+        auto& counts = chunkCounts[chunk];
+        for (auto& count : counts) {
+            count.fill(0);
+        }
+        for (auto iter = first + chunkBegin(chunk), end = first + chunkBegin(chunk + 1); iter != end; ++iter) {
+            Key k = key(*iter);
+            for (int d = 0; d < digits; ++d) {
+                ++counts[d][(k >> (8 * d)) & 0xff];
+            }
+        }
+    });
+
+    std::vector<V> buffer(n);
+    std::vector<Counts> offsets(chunks);
+    bool inBuffer = false;
+    bool countsValid = true;
+    for (int d = 0; d < digits; ++d) {
+        Counts total{};
+        for (auto& counts : chunkCounts) {
+            for (int digit = 0; digit < 256; ++digit) {
+                total[digit] += counts[d][digit];
+            }
+        }
+        if (std::find(total.begin(), total.end(), n) != total.end()) {
+            continue;
+        }
+
+        const int shift = 8 * d;
+        if (!countsValid) {
+            forEachChunk([&](std::ptrdiff_t chunk) {
+                auto& count = chunkCounts[chunk][d];
+                count.fill(0);
+                auto begin = chunkBegin(chunk);
+                auto end = chunkBegin(chunk + 1);
+                for (auto i = begin; i < end; ++i) {
+                    ++count[(key(inBuffer ? buffer[i] : first[i]) >> shift) & 0xff];
+                }
+            });
+        }
+        countsValid = false;
+
+        std::ptrdiff_t sum = 0;
+        for (int digit = 0; digit < 256; ++digit) {
+            for (std::ptrdiff_t chunk = 0; chunk < chunks; ++chunk) {
+                offsets[chunk][digit] = sum;
+                sum += chunkCounts[chunk][d][digit];
+            }
+        }
+
+        forEachChunk([&](std::ptrdiff_t chunk) {
+            auto begin = chunkBegin(chunk);
+            auto end = chunkBegin(chunk + 1);
+            if (inBuffer) {
+                radixScatterBuffered(buffer.begin() + begin, buffer.begin() + end, first, key, shift,
+                                     offsets[chunk].data());
+            } else {
+                radixScatterBuffered(first + begin, first + end, buffer.begin(), key, shift, offsets[chunk].data());
+            }
+        });
+        inBuffer = !inBuffer;
+    }
+    if (inBuffer) {
+        forEachChunk([&](std::ptrdiff_t chunk) {
+            std::move(buffer.begin() + chunkBegin(chunk), buffer.begin() + chunkBegin(chunk + 1),
+                      first + chunkBegin(chunk));
+        });
+    }
+}
+
+/// компараторы, отличные от std::less и std::greater, ключом не выражаются и сортируются myparallel_sort'ом
+template <typename T, typename Comp>
+void myparallel_radix_sort(T first, T last, Comp comp, ThreadPool& pool) {
+    using V = typename std::iterator_traits<T>::value_type;
+    if constexpr (RadixOrder<Comp, V>::value == 0) {
+        myparallel_sort(first, last, comp, pool);
+    } else {
+        parallelRadixSortImpl(first, last, comp, pool);
+    }
+}
+
+template <typename T, typename Comp>
+void myparallel_radix_sort(T first, T last, Comp comp) {
+    myparallel_radix_sort(first, last, comp, defaultThreadPool());
+}
+
+template <typename T, typename Comp>
+constexpr void sort3(T a, T b, T c, Comp comp) {
+    if (comp(*b, *a)) {
+        std::swap(*a, *b);
+    }
+    if (comp(*c, *b)) {
+        std::swap(*b, *c);
+    }
+    if (comp(*b, *a)) {
+        std::swap(*a, *b);
+    }
+}
+
+/// insertion sort, который сдается после limit перемещений элементов; true, если отрезок отсортирован
+template <typename T, typename Comp>
+constexpr bool partialInsertionSort(T first, T last, Comp comp) {
+    const std::ptrdiff_t limit = 8;
+    if (first == last) {
+        return true;
+    }
+    std::ptrdiff_t moves = 0;
+    for (auto cur = first + 1; cur != last; ++cur) {
+        for (auto iter = cur; iter > first && comp(*iter, *(iter - 1)); --iter) {
+            std::swap(*iter, *(iter - 1));
+            ++moves;
+        }
+        if (moves > limit) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// опорный элемент лежит в *first; равные ему элементы уходят вправо.
+/// second == true, если отрезок уже был разбит и не понадобилось ни одного обмена
+template <typename T, typename Comp>
+constexpr std::pair<T, bool> pdqPartitionRight(T begin, T end, Comp comp) {
+    auto pivotVal = *begin;
+    T first = begin;
+    T last = end;
+
+    // медиана трех гарантирует, что справа есть элемент не меньше опорного
+    while (comp(*++first, pivotVal)) {
+    }
+    if (first - 1 == begin) {
+        while (first < last && !comp(*--last, pivotVal)) {
+        }
+    } else {
+        while (!comp(*--last, pivotVal)) {
+        }
+    }
+
+    bool alreadyPartitioned = first >= last;
+    while (first < last) {
+        std::swap(*first, *last);
+        while (comp(*++first, pivotVal)) {
+        }
+        while (!comp(*--last, pivotVal)) {
+        }
+    }
+
+    T pivot = first - 1;
+    std::swap(*begin, *pivot);
+    return {pivot, alreadyPartitioned};
+}
+
+/// опорный элемент лежит в *first; равные ему элементы уходят влево
+template <typename T, typename Comp>
+constexpr T pdqPartitionLeft(T begin, T end, Comp comp) {
+    auto pivotVal = *begin;
+    T first = begin;
+    T last = end;
+
+    while (comp(pivotVal, *--last)) {
+    }
+    if (last + 1 == end) {
+        while (first < last && !comp(pivotVal, *++first)) {
+        }
+    } else {
+        while (!comp(pivotVal, *++first)) {
+        }
+    }
+
+    while (first < last) {
+        std::swap(*first, *last);
+        while (comp(pivotVal, *--last)) {
+        }
+        while (!comp(pivotVal, *++first)) {
+        }
+    }
+
+    std::swap(*begin, *last);
+    return last;
+}
+
+/// ломает паттерны во входных данных, переставляя несколько элементов плохо разбитого отрезка
+template <typename T>
+constexpr void pdqBreakPatterns(T first, T last) {
+    auto n = std::distance(first, last);
+    if (n < 24) {
+        return;
+    }
+    std::swap(*first, *(first + n / 4));
+    std::swap(*(last - 1), *(last - n / 4));
+    if (n > 128) {
+        std::swap(*(first + 1), *(first + (n / 4 + 1)));
+        std::swap(*(first + 2), *(first + (n / 4 + 2)));
+        std::swap(*(last - 2), *(last - (n / 4 + 1)));
+        std::swap(*(last - 3), *(last - (n / 4 + 2)));
+    }
+}
+
+template <typename T, typename Comp>
+constexpr void pdqSortLoop(T begin, T end, Comp comp, int badAllowed, bool leftmost) {
+    while (true) {
+        auto n = std::distance(begin, end);
+        if (n < 24) {
+            insertionSort(begin, end, comp);
+            return;
+        }
+
+        auto half = n / 2;
+        if (n > 128) {
+            sort3(begin, begin + half, end - 1, comp);
+            sort3(begin + 1, begin + (half - 1), end - 2, comp);
+            sort3(begin + 2, begin + (half + 1), end - 3, comp);
+            sort3(begin + (half - 1), begin + half, begin + (half + 1), comp);
+            std::swap(*begin, *(begin + half));
+        } else {
+            sort3(begin + half, begin, end - 1, comp);
+        }
+
+        if (!leftmost && !comp(*(begin - 1), *begin)) {
+            begin = pdqPartitionLeft(begin, end, comp) + 1;
+            continue;
+        }
+
+        auto partition = pdqPartitionRight(begin, end, comp);
+        T pivot = partition.first;
+
+        auto n1 = std::distance(begin, pivot);
+        auto n2 = std::distance(pivot + 1, end);
+        if (n1 < n / 8 || n2 < n / 8) {
+            if (--badAllowed == 0) {
+                heapSort(begin, end, comp);
+                return;
+            }
+            pdqBreakPatterns(begin, pivot);
+            pdqBreakPatterns(pivot + 1, end);
+        } else if (partition.second
+                   && partialInsertionSort(begin, pivot, comp)
+                   && partialInsertionSort(pivot + 1, end, comp)) {
+            return;
+        }
+
+        pdqSortLoop(begin, pivot, comp, badAllowed, leftmost);
+        begin = pivot + 1;
+        leftmost = false;
+    }
+}
+
+/// pattern-defeating quicksort: линейное время на отсортированных и почти отсортированных данных,
+/// O(n log n) в худшем случае
+template <typename T, typename Comp>
+constexpr void mypdqsort(T first, T last, Comp comp) {
+    auto n = std::distance(first, last);
+    if (n < 2) {
+        return;
     }
+    pdqSortLoop(first, last, comp, floorLog2(n), true);
 }
@@ -1,6 +1,17 @@
 #define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
 
 #include "catch.hpp"
 #include "sort.h"
@@ -70,9 +81,1517 @@ TEST_CASE( "sort test", "[basic]" ) {
             mysort(vForMySort.begin(), vForMySort.end(), comp);
 
             auto vForStdSort = v;
-            mysort(vForStdSort.begin(), vForStdSort.end(), comp);
+            std::sort(vForStdSort.begin(), vForStdSort.end(), comp);
 
             REQUIRE(VectorEqual(vForMySort, vForStdSort));
         }
     }
 }
+
+/// противник Макилроя (A Killer Adversary for Quicksort): значения элементов назначаются лениво
+/// во время сравнений так, чтобы опорный элемент всегда оказывался плохим
+struct AntiQsortState {
+    std::vector<int> val;
+    int gas;
+    int nsolid = 0;
+    int candidate = 0;
+    long long comparisons = 0;
+
+    explicit AntiQsortState(size_t n) : val(n, static_cast<int>(n)), gas(static_cast<int>(n)) {}
+
+    void freeze(int x) {
+        val[x] = nsolid++;
+    }
+};
+
+struct AntiQsortComp {
+    AntiQsortState* state;
+
+    bool operator()(int x, int y) const {
+        auto& s = *state;
+        ++s.comparisons;
+        if (s.val[x] == s.gas && s.val[y] == s.gas) {
+            s.freeze(x == s.candidate ? x : y);
+        }
+        if (s.val[x] == s.gas) {
+            s.candidate = x;
+        } else if (s.val[y] == s.gas) {
+            s.candidate = y;
+        }
+        return s.val[x] < s.val[y];
+    }
+};
+
+TEST_CASE( "introsort test", "[introsort]" ) {
+    auto comp = std::less<int>();
+
+    SECTION("heapSort") {
+        for (int i = 0; i < 100; ++i) {
+            std::vector<int> v = MakeRandomVector(i, 0, 100);
+
+            auto vForHeapSort = v;
+            heapSort(vForHeapSort.begin(), vForHeapSort.end(), comp);
+
+            std::sort(v.begin(), v.end(), comp);
+            REQUIRE(VectorEqual(vForHeapSort, v));
+        }
+    }
+
+    SECTION("depth limit 0 falls back to heapSort") {
+        std::vector<int> v = MakeRandomVector(1000, 0, 1000);
+        auto vForIntroSort = v;
+        introSort(vForIntroSort.begin(), vForIntroSort.end(), comp, 0);
+        std::sort(v.begin(), v.end(), comp);
+        REQUIRE(VectorEqual(vForIntroSort, v));
+    }
+
+    SECTION("adversarial input stays O(n log n)") {
+        const size_t n = 1 << 14;
+        AntiQsortState state(n);
+        std::vector<int> v(n);
+        std::iota(v.begin(), v.end(), 0);
+
+        mysort(v.begin(), v.end(), AntiQsortComp{&state});
+
+        REQUIRE(std::is_sorted(v.begin(), v.end(), AntiQsortComp{&state}));
+        REQUIRE(state.comparisons < 6 * static_cast<long long>(n) * static_cast<long long>(std::log2(n)));
+    }
+}
+
+template <typename Comp>
+struct CountingComp {
+    Comp comp;
+    long long* comparisons;
+
+    template <typename U>
+    bool operator()(const U& a, const U& b) const {
+        ++*comparisons;
+        return comp(a, b);
+    }
+};
+
+template <typename Comp>
+CountingComp<Comp> MakeCountingComp(Comp comp, long long* comparisons) {
+    return CountingComp<Comp>{comp, comparisons};
+}
+
+TEST_CASE( "three-way partition test", "[partition3way]" ) {
+    auto comp = std::less<int>();
+
+    SECTION("mypartition3way groups equal elements") {
+        for (int i = 1; i < 100; ++i) {
+            std::vector<int> v = MakeRandomVector(i, 0, 5);
+            int pivotVal = v[i / 2];
+            auto equalRange = mypartition3way(v.begin(), v.end(), v.begin() + i / 2, comp);
+
+            REQUIRE(std::all_of(v.begin(), equalRange.first, [&](int x) { return x < pivotVal; }));
+            REQUIRE(std::all_of(equalRange.first, equalRange.second, [&](int x) { return x == pivotVal; }));
+            REQUIRE(std::all_of(equalRange.second, v.end(), [&](int x) { return x > pivotVal; }));
+        }
+    }
+
+    SECTION("few distinct values stay O(n log n)") {
+        const size_t n = 100000;
+        for (int distinct : {1, 2, 4, 16}) {
+            std::vector<int> v = MakeRandomVector<int>(n, 0, distinct);
+            auto expected = v;
+            std::sort(expected.begin(), expected.end());
+
+            long long comparisons = 0;
+            mysort(v.begin(), v.end(), MakeCountingComp(comp, &comparisons));
+
+            REQUIRE(VectorEqual(v, expected));
+            REQUIRE(comparisons < 4 * static_cast<long long>(n) * (1 + distinct));
+        }
+    }
+}
+
+/// типичные паттерны входных данных: отсортированные, обратные, "органная труба", пила, дубликаты
+std::vector<std::vector<int>> MakePatternVectors(size_t n) {
+    std::vector<std::vector<int>> patterns(6, std::vector<int>(n));
+    for (size_t i = 0; i < n; ++i) {
+        int x = static_cast<int>(i);
+        int size = static_cast<int>(n);
+        patterns[0][i] = x;
+        patterns[1][i] = size - x;
+        patterns[2][i] = x < size / 2 ? x : size - x;
+        patterns[3][i] = x % 100;
+        patterns[4][i] = rand() % 10;
+        patterns[5][i] = rand();
+    }
+    return patterns;
+}
+
+TEST_CASE( "pdqsort test", "[pdqsort]" ) {
+    auto comp = std::less<int>();
+
+    SECTION("gen random vector and compare with std::sort") {
+        for (int i = 0; i < 300; ++i) {
+            std::vector<int> v = MakeRandomVector(i, 0, 100);
+
+            auto vForMySort = v;
+            mypdqsort(vForMySort.begin(), vForMySort.end(), comp);
+
+            std::sort(v.begin(), v.end(), comp);
+            REQUIRE(VectorEqual(vForMySort, v));
+        }
+    }
+
+    SECTION("patterns") {
+        for (size_t n : {10, 100, 1000, 100000}) {
+            for (auto& v : MakePatternVectors(n)) {
+                auto expected = v;
+                std::sort(expected.begin(), expected.end(), comp);
+                mypdqsort(v.begin(), v.end(), comp);
+                REQUIRE(VectorEqual(v, expected));
+            }
+        }
+    }
+
+    SECTION("sorted and reversed input takes linear time") {
+        const size_t n = 100000;
+        auto patterns = MakePatternVectors(n);
+        for (int p : {0, 1}) {
+            long long comparisons = 0;
+            mypdqsort(patterns[p].begin(), patterns[p].end(), MakeCountingComp(comp, &comparisons));
+            REQUIRE(std::is_sorted(patterns[p].begin(), patterns[p].end()));
+            REQUIRE(comparisons < 4 * static_cast<long long>(n));
+        }
+    }
+
+    SECTION("adversarial input stays O(n log n)") {
+        const size_t n = 1 << 14;
+        AntiQsortState state(n);
+        std::vector<int> v(n);
+        std::iota(v.begin(), v.end(), 0);
+
+        mypdqsort(v.begin(), v.end(), AntiQsortComp{&state});
+
+        REQUIRE(std::is_sorted(v.begin(), v.end(), AntiQsortComp{&state}));
+        REQUIRE(state.comparisons < 6 * static_cast<long long>(n) * static_cast<long long>(std::log2(n)));
+    }
+}
+
+TEST_CASE( "block partition test", "[blockpartition]" ) {
+    auto comp = std::less<int>();
+
+    SECTION("mypartition_block splits around pivot") {
+        for (int i = 1; i < 1000; i += 7) {
+            std::vector<int> v = MakeRandomVector(i, 0, 50);
+            int pivotVal = v[i / 3];
+            auto pivot = mypartition_block(v.begin(), v.end(), v.begin() + i / 3, comp);
+
+            REQUIRE(*pivot == pivotVal);
+            REQUIRE(std::all_of(v.begin(), pivot, [&](int x) { return x < pivotVal; }));
+            REQUIRE(std::all_of(pivot, v.end(), [&](int x) { return x >= pivotVal; }));
+        }
+    }
+
+    SECTION("mysort with BlockPartition") {
+        for (size_t n : {0, 1, 2, 10, 100, 1000, 100000}) {
+            for (auto& v : MakePatternVectors(n)) {
+                auto expected = v;
+                std::sort(expected.begin(), expected.end(), comp);
+                mysort(v.begin(), v.end(), comp, BlockPartition());
+                REQUIRE(VectorEqual(v, expected));
+            }
+        }
+    }
+
+    SECTION("non arithmetic keys") {
+        std::vector<std::string> v;
+        for (int x : MakeRandomVector(5000, 0, 1000)) {
+            v.push_back(std::to_string(x));
+        }
+        auto expected = v;
+        std::sort(expected.begin(), expected.end());
+        mysort(v.begin(), v.end(), std::less<std::string>(), BlockPartition());
+        REQUIRE(VectorEqual(v, expected));
+    }
+}
+
+template <typename Pivot>
+long long CountSortComparisons(std::vector<int> v, Pivot pivot) {
+    long long comparisons = 0;
+    auto comp = MakeCountingComp(std::less<int>(), &comparisons);
+    mysort(v.begin(), v.end(), comp, DefaultPartition(), pivot);
+    REQUIRE(std::is_sorted(v.begin(), v.end()));
+    return comparisons;
+}
+
+/// стратегия-шпион: записывает номер своего вызова; если стратегия копируется в подотрезки, номера повторяются
+struct CallLoggingPivot {
+    std::vector<int>* log;
+    int calls = 0;
+
+    template <typename T, typename Comp>
+    T operator()(T first, T last, Comp comp) {
+        log->push_back(calls++);
+        return MedianOfThreePivot()(first, last, comp);
+    }
+};
+
+TEST_CASE( "pivot policy test", "[pivot]" ) {
+    auto comp = std::less<int>();
+
+    SECTION("medianOf3") {
+        std::vector<int> v = {1, 2, 3};
+        do {
+            REQUIRE(*medianOf3(v.begin(), v.begin() + 1, v.begin() + 2, comp) == 2);
+        } while (std::next_permutation(v.begin(), v.end()));
+    }
+
+    SECTION("all policies sort patterns") {
+        for (size_t n : {0, 1, 2, 10, 100, 1000, 10000}) {
+            for (auto& v : MakePatternVectors(n)) {
+                auto expected = v;
+                std::sort(expected.begin(), expected.end(), comp);
+
+                auto v1 = v;
+                mysort(v1.begin(), v1.end(), comp, DefaultPartition(), MiddlePivot());
+                REQUIRE(VectorEqual(v1, expected));
+                auto v2 = v;
+                mysort(v2.begin(), v2.end(), comp, DefaultPartition(), MedianOfThreePivot());
+                REQUIRE(VectorEqual(v2, expected));
+                auto v3 = v;
+                mysort(v3.begin(), v3.end(), comp, BlockPartition(), NintherPivot());
+                REQUIRE(VectorEqual(v3, expected));
+                auto v4 = v;
+                mysort(v4.begin(), v4.end(), comp, DefaultPartition(), RandomPivot(42));
+                REQUIRE(VectorEqual(v4, expected));
+            }
+        }
+    }
+
+    SECTION("default policy needs fewer comparisons than middle element") {
+        std::vector<int> v = MakeRandomVector(1000000, 0, 1 << 30);
+        REQUIRE(CountSortComparisons(v, DefaultPivot()) < CountSortComparisons(v, MiddlePivot()));
+        REQUIRE(CountSortComparisons(v, RandomPivot(1)) < CountSortComparisons(v, MiddlePivot()));
+    }
+
+    SECTION("policy state is shared by all subranges") {
+        std::vector<int> v = MakeRandomVector(10000, 0, 1 << 30);
+        std::vector<int> log;
+        mysort(v.begin(), v.end(), comp, DefaultPartition(), CallLoggingPivot{&log});
+        REQUIRE(std::is_sorted(v.begin(), v.end()));
+        std::vector<int> expected(log.size());
+        std::iota(expected.begin(), expected.end(), 0);
+        REQUIRE(log.size() > 1);
+        REQUIRE(VectorEqual(log, expected));
+    }
+}
+
+TEST_CASE( "parallel sort test", "[parallel]" ) {
+    auto comp = std::less<int>();
+    ThreadPool pool(4);
+
+    SECTION("patterns with small cutoff") {
+        for (size_t n : {0, 1, 2, 10, 1000, 100000}) {
+            for (auto& v : MakePatternVectors(n)) {
+                auto expected = v;
+                std::sort(expected.begin(), expected.end(), comp);
+                myparallel_sort(v.begin(), v.end(), comp, pool, 64);
+                REQUIRE(VectorEqual(v, expected));
+            }
+        }
+    }
+
+    SECTION("pool is reused between calls") {
+        for (int i = 0; i < 20; ++i) {
+            std::vector<int> v = MakeRandomVector(50000, 0, 1 << 30);
+            auto expected = v;
+            std::sort(expected.begin(), expected.end(), comp);
+            myparallel_sort(v.begin(), v.end(), comp, pool, 1000);
+            REQUIRE(VectorEqual(v, expected));
+        }
+    }
+
+    SECTION("default pool") {
+        std::vector<int> v = MakeRandomVector(200000, 0, 1 << 30);
+        auto expected = v;
+        std::sort(expected.begin(), expected.end(), comp);
+        myparallel_sort(v.begin(), v.end(), comp);
+        REQUIRE(VectorEqual(v, expected));
+    }
+
+    SECTION("exception from comparator is rethrown") {
+        std::vector<int> v = MakeRandomVector(100000, 0, 1 << 30);
+        auto throwingComp = [](int a, int b) {
+            if (a == b) {
+                throw std::runtime_error("equal elements");
+            }
+            return a < b;
+        };
+        v.push_back(v.front());
+        REQUIRE_THROWS_AS(myparallel_sort(v.begin(), v.end(), throwingComp, pool, 64), std::runtime_error);
+    }
+}
+
+TEST_CASE( "work stealing test", "[workstealing]" ) {
+    SECTION("owner pops LIFO, thieves steal FIFO") {
+        WorkStealingDeque<int> deque(2);
+        for (int i = 0; i < 10; ++i) {
+            deque.push(i);
+        }
+        int item = -1;
+        REQUIRE(deque.steal(item));
+        REQUIRE(item == 0);
+        REQUIRE(deque.pop(item));
+        REQUIRE(item == 9);
+        REQUIRE(deque.steal(item));
+        REQUIRE(item == 1);
+        for (int i = 8; i >= 2; --i) {
+            REQUIRE(deque.pop(item));
+            REQUIRE(item == i);
+        }
+        REQUIRE(deque.empty());
+        REQUIRE_FALSE(deque.pop(item));
+        REQUIRE_FALSE(deque.steal(item));
+    }
+
+    SECTION("every item is taken exactly once under concurrent stealing") {
+        const int n = 100000;
+        WorkStealingDeque<int> deque(4);
+        std::vector<std::atomic<int>> taken(n);
+        for (auto& counter : taken) {
+            counter = 0;
+        }
+        std::atomic<bool> done{false};
+
+        std::vector<std::thread> thieves;
+        for (int t = 0; t < 3; ++t) {
+            thieves.emplace_back([&] {
+                int item;
+                while (!done || !deque.empty()) {
+                    if (deque.steal(item)) {
+                        ++taken[item];
+                    }
+                }
+            });
+        }
+        int item;
+        for (int i = 0; i < n; ++i) {
+            deque.push(i);
+            if (i % 3 == 0 && deque.pop(item)) {
+                ++taken[item];
+            }
+        }
+        while (deque.pop(item)) {
+            ++taken[item];
+        }
+        done = true;
+        for (auto& thief : thieves) {
+            thief.join();
+        }
+        REQUIRE(std::all_of(taken.begin(), taken.end(), [](const std::atomic<int>& c) { return c == 1; }));
+    }
+
+    SECTION("nested tasks") {
+        ThreadPool pool(4);
+        std::atomic<int> counter{0};
+        {
+            TaskGroup group(pool);
+            for (int i = 0; i < 100; ++i) {
+                group.run([&] {
+                    for (int j = 0; j < 100; ++j) {
+                        group.run([&] { ++counter; });
+                    }
+                });
+            }
+            group.wait();
+        }
+        REQUIRE(counter == 100 * 100);
+    }
+
+    SECTION("skewed input") {
+        ThreadPool pool(4);
+        auto comp = std::less<int>();
+        for (auto& v : MakePatternVectors(200000)) {
+            auto expected = v;
+            std::sort(expected.begin(), expected.end(), comp);
+            myparallel_sort(v.begin(), v.end(), comp, pool, 256);
+            REQUIRE(VectorEqual(v, expected));
+        }
+    }
+}
+
+TEST_CASE( "parallel partition test", "[parallelpartition]" ) {
+    auto comp = std::less<int>();
+    ThreadPool pool(4);
+
+    SECTION("mypartition_parallel splits around pivot") {
+        for (size_t n : {1, 2, 100, 5000, 20000, 100000, 300001}) {
+            for (auto& v : MakePatternVectors(n)) {
+                auto sorted = v;
+                std::sort(sorted.begin(), sorted.end());
+                int pivotVal = v[n / 3];
+                auto pivot = mypartition_parallel(v.begin(), v.end(), v.begin() + n / 3, comp, pool);
+
+                REQUIRE(*pivot == pivotVal);
+                REQUIRE(std::all_of(v.begin(), pivot, [&](int x) { return x < pivotVal; }));
+                REQUIRE(std::all_of(pivot, v.end(), [&](int x) { return x >= pivotVal; }));
+                std::sort(v.begin(), v.end());
+                REQUIRE(VectorEqual(v, sorted));
+            }
+        }
+    }
+
+    SECTION("myparallel_sort on huge range") {
+        std::vector<int> v = MakeRandomVector(1 << 20, 0, 1 << 30);
+        auto expected = v;
+        std::sort(expected.begin(), expected.end(), comp);
+        myparallel_sort(v.begin(), v.end(), comp, pool);
+        REQUIRE(VectorEqual(v, expected));
+    }
+}
+
+template <typename V>
+void CheckArithmeticPartition() {
+    auto comp = std::less<V>();
+    for (int n : {1, 2, 7, 8, 9, 15, 16, 17, 31, 32, 33, 64, 100, 1000, 4097}) {
+        for (int distinct : {2, 1000000}) {
+            std::vector<V> v;
+            for (int x : MakeRandomVector(n, -distinct, distinct)) {
+                v.push_back(static_cast<V>(x));
+            }
+            auto sorted = v;
+            std::sort(sorted.begin(), sorted.end());
+
+            V pivotVal = v[n / 2];
+            auto pivot = mypartition(v.begin(), v.end(), v.begin() + n / 2, comp);
+            REQUIRE(*pivot == pivotVal);
+            REQUIRE(std::all_of(v.begin(), pivot, [&](V x) { return x < pivotVal; }));
+            REQUIRE(std::all_of(pivot, v.end(), [&](V x) { return !(x < pivotVal); }));
+
+            std::sort(v.begin(), v.end());
+            REQUIRE(VectorEqual(v, sorted));
+        }
+    }
+}
+
+TEST_CASE( "simd partition test", "[simd]" ) {
+    SECTION("int32_t") {
+        CheckArithmeticPartition<std::int32_t>();
+    }
+    SECTION("uint32_t") {
+        CheckArithmeticPartition<std::uint32_t>();
+    }
+    SECTION("int64_t") {
+        CheckArithmeticPartition<std::int64_t>();
+    }
+    SECTION("uint64_t") {
+        CheckArithmeticPartition<std::uint64_t>();
+    }
+    SECTION("float") {
+        CheckArithmeticPartition<float>();
+    }
+    SECTION("double") {
+        CheckArithmeticPartition<double>();
+    }
+
+    SECTION("mysort on vectorized types") {
+        std::vector<double> v;
+        for (int x : MakeRandomVector(100000, -1000000, 1000000)) {
+            v.push_back(x / 7.0);
+        }
+        auto expected = v;
+        std::sort(expected.begin(), expected.end());
+        mysort(v.begin(), v.end(), std::less<double>());
+        REQUIRE(VectorEqual(v, expected));
+
+        std::vector<std::uint32_t> u(100000);
+        for (auto& x : u) {
+            x = static_cast<std::uint32_t>(rand()) * 2654435761u;
+        }
+        auto expectedU = u;
+        std::sort(expectedU.begin(), expectedU.end());
+        mysort(u.data(), u.data() + u.size(), std::less<>());
+        REQUIRE(VectorEqual(u, expectedU));
+    }
+}
+
+/// -0.0 == +0.0, поэтому VectorEqual не отличит сортировку, потерявшую знак нуля; считаем знаковые биты
+template <typename V>
+std::vector<V> MakeSignedZeros(size_t n) {
+    std::vector<V> v;
+    for (int x : MakeRandomVector(n, 0, 4)) {
+        v.push_back(x == 0 ? V(-0.0) : x == 1 ? V(0.0) : x == 2 ? V(-1) : V(1));
+    }
+    return v;
+}
+
+template <typename V>
+std::ptrdiff_t CountSignBits(const std::vector<V>& v) {
+    return std::count_if(v.begin(), v.end(), [](V x) { return std::signbit(x); });
+}
+
+template <typename V>
+void CheckNetworkSort() {
+    for (std::ptrdiff_t n = 0; n <= networkSortSize; ++n) {
+        for (int iteration = 0; iteration < 50; ++iteration) {
+            std::vector<V> v;
+            for (int x : MakeRandomVector(n, -100, 100)) {
+                v.push_back(static_cast<V>(x));
+            }
+            if (n > 0) {
+                v[rand() % n] = std::numeric_limits<V>::max();
+                v[rand() % n] = std::numeric_limits<V>::lowest();
+            }
+            auto expected = v;
+            std::sort(expected.begin(), expected.end());
+            networkSort(v.data(), n);
+            REQUIRE(VectorEqual(v, expected));
+        }
+        if constexpr (std::is_floating_point<V>::value) {
+            for (int iteration = 0; iteration < 50; ++iteration) {
+                auto v = MakeSignedZeros<V>(n);
+                auto negativeZeros = CountSignBits(v);
+                networkSort(v.data(), n);
+                REQUIRE(std::is_sorted(v.begin(), v.end()));
+                REQUIRE(CountSignBits(v) == negativeZeros);
+            }
+        }
+    }
+}
+
+TEST_CASE( "sorting network test", "[network]" ) {
+    SECTION("int32_t") {
+        CheckNetworkSort<std::int32_t>();
+    }
+    SECTION("uint32_t") {
+        CheckNetworkSort<std::uint32_t>();
+    }
+    SECTION("int64_t") {
+        CheckNetworkSort<std::int64_t>();
+    }
+    SECTION("uint8_t") {
+        CheckNetworkSort<std::uint8_t>();
+    }
+    SECTION("float") {
+        CheckNetworkSort<float>();
+    }
+    SECTION("double") {
+        CheckNetworkSort<double>();
+    }
+
+    SECTION("infinity") {
+        std::vector<float> v = {std::numeric_limits<float>::infinity(), 1.0f, -std::numeric_limits<float>::infinity()};
+        networkSort(v.data(), 3);
+        REQUIRE(VectorEqual(v, {-std::numeric_limits<float>::infinity(), 1.0f,
+                                std::numeric_limits<float>::infinity()}));
+    }
+
+    SECTION("mysort leaves") {
+        for (int i = 0; i < 300; ++i) {
+            std::vector<std::int64_t> v;
+            for (int x : MakeRandomVector(i, -1000, 1000)) {
+                v.push_back(x);
+            }
+            auto expected = v;
+            std::sort(expected.begin(), expected.end());
+            mysort(v.begin(), v.end(), std::less<std::int64_t>());
+            REQUIRE(VectorEqual(v, expected));
+        }
+    }
+
+    SECTION("signed zero leaves") {
+        for (int n = 2; n < 300; ++n) {
+            auto v = MakeSignedZeros<float>(n);
+            auto negativeZeros = CountSignBits(v);
+            auto w = v;
+            mysort(v.begin(), v.end(), std::less<float>());
+            REQUIRE(std::is_sorted(v.begin(), v.end()));
+            REQUIRE(CountSignBits(v) == negativeZeros);
+
+            mynth_element(w.begin(), w.begin() + n / 2, w.end(), std::less<float>());
+            REQUIRE(CountSignBits(w) == negativeZeros);
+        }
+    }
+}
+
+static_assert(SortingNetwork<0>::size == 0, "");
+static_assert(SortingNetwork<1>::size == 0, "");
+static_assert(SortingNetwork<2>::size == 1, "");
+static_assert(SortingNetwork<4>::size == 5, "");
+static_assert(SortingNetwork<8>::size == 19, "");
+static_assert(SortingNetwork<16>::size == 63, "");
+
+/// по принципу нулей и единиц сеть сортирует любые данные, если сортирует все последовательности из 0 и 1
+template <std::size_t N>
+void CheckNetworkZeroOne() {
+    for (unsigned mask = 0; mask < (1u << N); ++mask) {
+        std::array<int, N> a;
+        for (std::size_t i = 0; i < N; ++i) {
+            a[i] = (mask >> i) & 1;
+        }
+        mysort(a);
+        REQUIRE(std::is_sorted(a.begin(), a.end()));
+    }
+}
+
+template <std::size_t N>
+void CheckNetworkRandom() {
+    for (int iteration = 0; iteration < 100; ++iteration) {
+        std::array<float, N> a;
+        for (auto& x : a) {
+            x = static_cast<float>(rand() % 100);
+        }
+        auto expected = a;
+        std::sort(expected.begin(), expected.end(), std::greater<float>());
+        mysort(a, std::greater<float>());
+        REQUIRE(a == expected);
+    }
+}
+
+TEST_CASE( "compile-time sorting network test", "[staticnetwork]" ) {
+    SECTION("zero-one principle") {
+        CheckNetworkZeroOne<0>();
+        CheckNetworkZeroOne<1>();
+        CheckNetworkZeroOne<2>();
+        CheckNetworkZeroOne<3>();
+        CheckNetworkZeroOne<5>();
+        CheckNetworkZeroOne<7>();
+        CheckNetworkZeroOne<8>();
+        CheckNetworkZeroOne<11>();
+        CheckNetworkZeroOne<13>();
+        CheckNetworkZeroOne<16>();
+    }
+
+    SECTION("random arrays") {
+        CheckNetworkRandom<4>();
+        CheckNetworkRandom<6>();
+        CheckNetworkRandom<9>();
+        CheckNetworkRandom<17>();
+        CheckNetworkRandom<24>();
+        CheckNetworkRandom<32>();
+    }
+
+    SECTION("sort_n on iterators") {
+        std::vector<std::string> v = {"d", "b", "e", "a", "c", "z"};
+        sort_n<5>(v.begin());
+        REQUIRE(VectorEqual(v, {"a", "b", "c", "d", "e", "z"}));
+    }
+}
+
+/// таблицы, отсортированные компилятором: при запуске программы сортировка не выполняется
+template <typename Partition>
+constexpr std::array<int, 300> MakeConstexprSortedTable(Partition partition) {
+    std::array<int, 300> table{};
+    unsigned state = 12345;
+    for (auto& x : table) {
+        state = state * 1103515245u + 12345u;
+        x = static_cast<int>((state >> 16) % 1000);
+    }
+    mysort(table.begin(), table.end(), std::less<int>(), partition);
+    return table;
+}
+
+constexpr std::array<std::string_view, 10> MakeConstexprKeywordTable() {
+    std::array<std::string_view, 10> keywords = {"while", "auto", "return", "if", "for",
+                                                 "switch", "case", "break", "else", "do"};
+    mysort(keywords);
+    return keywords;
+}
+
+constexpr std::array<int, 100> MakeConstexprHeapSortedTable() {
+    std::array<int, 100> table{};
+    for (int i = 0; i < 100; ++i) {
+        table[i] = (i * 37) % 100;
+    }
+    introSort(table.begin(), table.end(), std::greater<int>(), 0);
+    return table;
+}
+
+constexpr auto constexprSortedTable = MakeConstexprSortedTable(DefaultPartition());
+constexpr auto constexprBlockSortedTable = MakeConstexprSortedTable(BlockPartition());
+constexpr auto constexprKeywordTable = MakeConstexprKeywordTable();
+constexpr auto constexprHeapSortedTable = MakeConstexprHeapSortedTable();
+
+static_assert(std::is_sorted(constexprSortedTable.begin(), constexprSortedTable.end()));
+static_assert(constexprSortedTable == constexprBlockSortedTable);
+static_assert(std::is_sorted(constexprKeywordTable.begin(), constexprKeywordTable.end()));
+static_assert(constexprKeywordTable.front() == "auto" && constexprKeywordTable.back() == "while");
+static_assert(std::is_sorted(constexprHeapSortedTable.begin(), constexprHeapSortedTable.end(), std::greater<int>()));
+
+TEST_CASE( "constexpr sort test", "[constexpr]" ) {
+    auto table = MakeConstexprSortedTable(DefaultPartition());
+    REQUIRE(table == constexprSortedTable);
+    REQUIRE(std::binary_search(constexprKeywordTable.begin(), constexprKeywordTable.end(), "switch"));
+}
+
+template <typename V, typename Comp>
+void CheckRadixSort(Comp comp) {
+    for (int n : {0, 1, 2, 100, 3000, 20000}) {
+        for (int bits : {4, 8 * static_cast<int>(sizeof(V))}) {
+            std::vector<V> v(n);
+            for (auto& x : v) {
+                auto r = (static_cast<std::uint64_t>(rand()) << 32) ^ static_cast<std::uint64_t>(rand());
+                x = static_cast<V>(bits < 64 ? r & ((std::uint64_t(1) << bits) - 1) : r);
+                if (rand() % 2) {
+                    x = static_cast<V>(-x);
+                }
+            }
+            auto expected = v;
+            std::sort(expected.begin(), expected.end(), comp);
+
+            auto vForRadix = v;
+            myradix_sort(vForRadix.begin(), vForRadix.end(), comp);
+            REQUIRE(VectorEqual(vForRadix, expected));
+
+            mysort(v.begin(), v.end(), comp);
+            REQUIRE(VectorEqual(v, expected));
+        }
+    }
+}
+
+TEST_CASE( "radix sort test", "[radix]" ) {
+    static_assert(IsRadixSortable<std::vector<int>::iterator, std::less<int>>::value);
+    static_assert(IsRadixSortable<std::uint64_t*, std::greater<>>::value);
+    static_assert(!IsRadixSortable<float*, std::less<float>>::value);
+    static_assert(!IsRadixSortable<int*, std::less_equal<int>>::value);
+
+    SECTION("int32_t") {
+        CheckRadixSort<std::int32_t>(std::less<std::int32_t>());
+        CheckRadixSort<std::int32_t>(std::greater<std::int32_t>());
+    }
+    SECTION("uint32_t") {
+        CheckRadixSort<std::uint32_t>(std::less<>());
+    }
+    SECTION("int64_t") {
+        CheckRadixSort<std::int64_t>(std::less<std::int64_t>());
+        CheckRadixSort<std::int64_t>(std::greater<>());
+    }
+    SECTION("uint64_t") {
+        CheckRadixSort<std::uint64_t>(std::greater<std::uint64_t>());
+    }
+    SECTION("int8_t and int16_t") {
+        CheckRadixSort<std::int8_t>(std::less<std::int8_t>());
+        CheckRadixSort<std::int16_t>(std::greater<std::int16_t>());
+    }
+    SECTION("arbitrary comparator") {
+        std::vector<int> v = {5, 3, 1, 4, 2};
+        myradix_sort(v.begin(), v.end(), [](int a, int b) { return a > b; });
+        REQUIRE(VectorEqual(v, {5, 4, 3, 2, 1}));
+        CheckRadixSort<std::int64_t>([](std::int64_t a, std::int64_t b) { return a > b; });
+    }
+}
+
+template <typename V, typename Comp>
+void CheckMsdRadixSort(std::vector<V> v, Comp comp) {
+    auto expected = v;
+    std::sort(expected.begin(), expected.end(), comp);
+    mymsd_radix_sort(v.begin(), v.end(), comp);
+    REQUIRE(VectorEqual(v, expected));
+}
+
+TEST_CASE( "msd radix sort test", "[msdradix]" ) {
+    SECTION("integers") {
+        for (int n : {0, 1, 2, 50, 1000, 100000}) {
+            std::vector<std::int64_t> v;
+            for (int x : MakeRandomVector(n, -1000000, 1000000)) {
+                v.push_back(static_cast<std::int64_t>(x) * 1000003);
+            }
+            CheckMsdRadixSort(v, std::less<std::int64_t>());
+            CheckMsdRadixSort(v, std::greater<>());
+
+            std::vector<std::uint32_t> u(n);
+            for (auto& x : u) {
+                x = static_cast<std::uint32_t>(rand()) % 300;
+            }
+            CheckMsdRadixSort(u, std::less<>());
+        }
+    }
+
+    SECTION("floating point") {
+        for (int n : {0, 1, 2, 50, 1000, 100000}) {
+            std::vector<double> d;
+            std::vector<float> f;
+            for (int x : MakeRandomVector(n, -1000000, 1000000)) {
+                d.push_back(x / 3.0);
+                f.push_back(static_cast<float>(x) * 1e-3f);
+            }
+            if (n > 2) {
+                d[0] = std::numeric_limits<double>::infinity();
+                d[1] = -std::numeric_limits<double>::infinity();
+                f[0] = std::numeric_limits<float>::lowest();
+            }
+            CheckMsdRadixSort(d, std::less<double>());
+            CheckMsdRadixSort(d, std::greater<double>());
+            CheckMsdRadixSort(f, std::less<float>());
+        }
+    }
+
+    SECTION("fixed-width keys") {
+        struct Record {
+            std::uint16_t key;
+            int payload;
+        };
+        std::vector<Record> records;
+        for (int x : MakeRandomVector(50000, 0, 65535)) {
+            records.push_back({static_cast<std::uint16_t>(x), x});
+        }
+        mymsd_radix_sort_by_key(records.begin(), records.end(), [](const Record& r) { return r.key; });
+        REQUIRE(std::is_sorted(records.begin(), records.end(),
+                               [](const Record& a, const Record& b) { return a.key < b.key; }));
+        REQUIRE(std::all_of(records.begin(), records.end(), [](const Record& r) { return r.key == r.payload; }));
+    }
+}
+
+template <typename V, typename Comp>
+void CheckParallelRadixSort(ThreadPool& pool, int n, int bits, Comp comp) {
+    std::vector<V> v(n);
+    for (auto& x : v) {
+        auto r = (static_cast<std::uint64_t>(rand()) << 32) ^ static_cast<std::uint64_t>(rand());
+        x = static_cast<V>(bits < 64 ? r & ((std::uint64_t(1) << bits) - 1) : r);
+    }
+    auto expected = v;
+    std::sort(expected.begin(), expected.end(), comp);
+    myparallel_radix_sort(v.begin(), v.end(), comp, pool);
+    REQUIRE(VectorEqual(v, expected));
+}
+
+TEST_CASE( "parallel radix sort test", "[parallelradix]" ) {
+    for (std::size_t threads : {1, 3, 4}) {
+        ThreadPool pool(threads);
+        for (int n : {0, 1, 1000, 100000, 300001}) {
+            CheckParallelRadixSort<std::int32_t>(pool, n, 32, std::less<std::int32_t>());
+            CheckParallelRadixSort<std::int32_t>(pool, n, 12, std::greater<>());
+            CheckParallelRadixSort<std::uint64_t>(pool, n, 64, std::less<>());
+            CheckParallelRadixSort<std::int16_t>(pool, n, 16, std::greater<std::int16_t>());
+            CheckParallelRadixSort<std::uint32_t>(pool, n, 32, [](std::uint32_t a, std::uint32_t b) { return a > b; });
+        }
+    }
+
+    SECTION("default pool") {
+        auto v = MakeRandomVector(200000, -1000000, 1000000);
+        auto expected = v;
+        std::sort(expected.begin(), expected.end());
+        myparallel_radix_sort(v.begin(), v.end(), std::less<int>());
+        REQUIRE(VectorEqual(v, expected));
+    }
+}
+
+std::vector<std::string> MakeRandomStrings(size_t n, const std::string& prefix, int maxLength, int alphabet) {
+    std::vector<std::string> v(n);
+    for (auto& s : v) {
+        s = prefix;
+        int length = rand() % (maxLength + 1);
+        for (int i = 0; i < length; ++i) {
+            s.push_back(static_cast<char>(rand() % alphabet + (alphabet > 128 ? 0 : 'a')));
+        }
+    }
+    return v;
+}
+
+TEST_CASE( "multikey quicksort test", "[multikey]" ) {
+    static_assert(IsMultikeySortable<std::vector<std::string>::iterator, std::less<>>::value);
+    static_assert(!IsMultikeySortable<std::vector<std::string>::iterator, std::greater<std::string>>::value);
+
+    for (size_t n : {0, 1, 2, 10, 1000, 50000}) {
+        for (auto v : {MakeRandomStrings(n, "", 12, 26), MakeRandomStrings(n, "common/prefix/", 3, 4),
+                       MakeRandomStrings(n, "", 6, 256), std::vector<std::string>(n, "same")}) {
+            auto expected = v;
+            std::sort(expected.begin(), expected.end());
+
+            auto multikey = v;
+            mymultikey_sort(multikey.begin(), multikey.end());
+            REQUIRE(VectorEqual(multikey, expected));
+
+            mysort(v.begin(), v.end(), std::less<std::string>());
+            REQUIRE(VectorEqual(v, expected));
+        }
+    }
+
+    SECTION("string_view") {
+        auto storage = MakeRandomStrings(20000, "key", 5, 3);
+        std::vector<std::string_view> v(storage.begin(), storage.end());
+        auto expected = v;
+        std::sort(expected.begin(), expected.end());
+        mysort(v.begin(), v.end(), std::less<>());
+        REQUIRE(VectorEqual(v, expected));
+    }
+}
+
+TEST_CASE( "string radix sort test", "[stringradix]" ) {
+    for (size_t n : {0, 1, 2, 33, 1000, 50000}) {
+        for (auto v : {MakeRandomStrings(n, "", 20, 26), MakeRandomStrings(n, "https://example.com/", 10, 3),
+                       MakeRandomStrings(n, "", 12, 256), MakeRandomStrings(n, std::string(40, 'x'), 2, 2),
+                       std::vector<std::string>(n, "same")}) {
+            auto expected = v;
+            std::sort(expected.begin(), expected.end());
+            mystring_radix_sort(v.begin(), v.end());
+            REQUIRE(VectorEqual(v, expected));
+        }
+    }
+
+    SECTION("embedded zero bytes and prefixes") {
+        std::vector<std::string> v;
+        for (int i = 0; i < 2000; ++i) {
+            v.push_back(std::string(rand() % 12, 'a'));
+            v.push_back(std::string(rand() % 12, '\0'));
+            v.back().push_back(static_cast<char>(rand() % 2));
+        }
+        auto expected = v;
+        std::sort(expected.begin(), expected.end());
+        mystring_radix_sort(v.begin(), v.end());
+        REQUIRE(VectorEqual(v, expected));
+    }
+
+    SECTION("string_view") {
+        auto storage = MakeRandomStrings(20000, "", 9, 5);
+        std::vector<std::string_view> v(storage.begin(), storage.end());
+        auto expected = v;
+        std::sort(expected.begin(), expected.end());
+        mystring_radix_sort(v.begin(), v.end());
+        REQUIRE(VectorEqual(v, expected));
+    }
+}
+
+TEST_CASE( "sort by key test", "[sortbykey]" ) {
+    struct Object {
+        float x;
+        float y;
+        int id;
+    };
+    auto distance = [](const Object& o) { return o.x * o.x + o.y * o.y; };
+
+    for (int n : {0, 1, 100, 5000}) {
+        std::vector<Object> objects;
+        for (int i = 0; i < n; ++i) {
+            objects.push_back({static_cast<float>(rand() % 200 - 100), static_cast<float>(rand() % 200 - 100), i});
+        }
+        auto original = objects;
+
+        int calls = 0;
+        auto order = mysort_by_key(objects.begin(), objects.end(), [&](const Object& o) {
+            ++calls;
+            return distance(o);
+        });
+        REQUIRE(calls == n);
+        REQUIRE(order.size() == static_cast<size_t>(n));
+
+        // устойчивость: равные по расстоянию объекты сохраняют исходный порядок
+        auto expected = original;
+        std::stable_sort(expected.begin(), expected.end(),
+                         [&](const Object& a, const Object& b) { return distance(a) < distance(b); });
+        for (int i = 0; i < n; ++i) {
+            REQUIRE(objects[i].id == expected[i].id);
+            REQUIRE(order[i] == static_cast<size_t>(expected[i].id));
+        }
+    }
+
+    SECTION("order only") {
+        auto v = MakeRandomVector(3000, -50, 50);
+        auto original = v;
+        auto order = mysort_by_key(v.begin(), v.end(), [](int x) { return -x; }, false);
+        REQUIRE(VectorEqual(v, original));
+        for (size_t i = 1; i < order.size(); ++i) {
+            REQUIRE(-v[order[i - 1]] <= -v[order[i]]);
+            if (v[order[i - 1]] == v[order[i]]) {
+                REQUIRE(order[i - 1] < order[i]);
+            }
+        }
+    }
+
+    SECTION("signed zero keys") {
+        // -0.0 == +0.0, поэтому устойчивая сортировка должна сохранить их исходный порядок
+        std::vector<double> v(1000);
+        for (size_t i = 0; i < v.size(); ++i) {
+            v[i] = i % 2 ? -0.0 : 0.0;
+        }
+        auto order = mysort_by_key(v.begin(), v.end(), [](double x) { return x; }, false);
+        for (size_t i = 0; i < order.size(); ++i) {
+            REQUIRE(order[i] == i);
+        }
+    }
+
+    SECTION("non-radix key") {
+        std::vector<std::string> words = {"pear", "fig", "banana", "kiwi", "apple", "plum"};
+        mysort_by_key(words.begin(), words.end(), [](const std::string& w) { return w.size(); });
+        REQUIRE(VectorEqual(words, std::vector<std::string>{"fig", "pear", "kiwi", "plum", "apple", "banana"}));
+
+        std::vector<std::string> names = {"delta", "alpha", "charlie", "bravo"};
+        mysort_by_key(names.begin(), names.end(), [](const std::string& w) { return w; });
+        REQUIRE(VectorEqual(names, std::vector<std::string>{"alpha", "bravo", "charlie", "delta"}));
+    }
+}
+
+TEST_CASE( "argsort test", "[argsort]" ) {
+    SECTION("arithmetic keys") {
+        for (int n : {0, 1, 100, 5000}) {
+            auto v = MakeRandomVector(n, -100, 100);
+            auto order = myargsort(v.begin(), v.end(), std::greater<int>());
+            REQUIRE(order.size() == static_cast<size_t>(n));
+            for (int i = 1; i < n; ++i) {
+                REQUIRE(v[order[i - 1]] >= v[order[i]]);
+                if (v[order[i - 1]] == v[order[i]]) {
+                    REQUIRE(order[i - 1] < order[i]);
+                }
+            }
+        }
+    }
+
+    SECTION("signed zeros") {
+        for (int n : {10, 1000}) {
+            std::vector<double> v(n);
+            for (int i = 0; i < n; ++i) {
+                v[i] = i % 2 ? -0.0 : 0.0;
+            }
+            for (auto order : {myargsort(v.begin(), v.end(), std::less<double>()),
+                               myargsort(v.begin(), v.end(), std::greater<>())}) {
+                for (int i = 0; i < n; ++i) {
+                    REQUIRE(order[i] == static_cast<std::uint32_t>(i));
+                }
+            }
+        }
+    }
+
+    SECTION("custom comparators") {
+        struct Point {
+            int x;
+            int y;
+        };
+        std::vector<Point> points;
+        for (int i = 0; i < 3000; ++i) {
+            points.push_back({rand() % 50, rand() % 50});
+        }
+        auto byX = [](const Point& a, const Point& b) { return a.x < b.x; };
+        auto order = myargsort<std::uint64_t>(points.begin(), points.end(), byX);
+        static_assert(std::is_same<decltype(order), std::vector<std::uint64_t>>::value);
+
+        auto expected = points;
+        std::stable_sort(expected.begin(), expected.end(), byX);
+        for (size_t i = 0; i < points.size(); ++i) {
+            REQUIRE(points[order[i]].x == expected[i].x);
+            REQUIRE(points[order[i]].y == expected[i].y);
+        }
+
+        auto words = MakeRandomStrings(2000, "", 4, 3);
+        auto wordOrder = myargsort(words.begin(), words.end(), std::less<std::string>());
+        REQUIRE(std::is_sorted(wordOrder.begin(), wordOrder.end(), [&](std::uint32_t a, std::uint32_t b) {
+            return words[a] < words[b];
+        }));
+    }
+
+    SECTION("parallel columns") {
+        const int n = 10000;
+        std::vector<double> price(n);
+        std::vector<int> id(n);
+        std::vector<std::string> name(n);
+        for (int i = 0; i < n; ++i) {
+            price[i] = (rand() % 1000) / 10.0;
+            id[i] = i;
+            name[i] = std::to_string(i);
+        }
+        auto original = price;
+
+        auto order = myargsort_by_key(price.begin(), price.end(), [](double p) { return -p; });
+        myapply_permutation(order, price.begin(), id.begin(), name.begin());
+        REQUIRE(std::is_sorted(price.begin(), price.end(), std::greater<double>()));
+        for (int i = 0; i < n; ++i) {
+            REQUIRE(price[i] == original[id[i]]);
+            REQUIRE(name[i] == std::to_string(id[i]));
+            if (i > 0 && price[i] == price[i - 1]) {
+                REQUIRE(id[i - 1] < id[i]);
+            }
+        }
+    }
+
+    SECTION("apply permutation moves each element once") {
+        std::vector<std::uint32_t> order = {2, 0, 1, 3, 5, 4};
+        std::vector<std::unique_ptr<int>> values;
+        for (int i = 0; i < 6; ++i) {
+            values.push_back(std::make_unique<int>(i));
+        }
+        myapply_permutation(order, values.begin());
+        for (int i = 0; i < 6; ++i) {
+            REQUIRE(*values[i] == static_cast<int>(order[i]));
+        }
+    }
+}
+
+template <typename Comp>
+void CheckNthElement(std::vector<int> v, size_t k, Comp comp) {
+    auto sorted = v;
+    std::sort(sorted.begin(), sorted.end(), comp);
+    mynth_element(v.begin(), v.begin() + k, v.end(), comp);
+    REQUIRE(v[k] == sorted[k]);
+    REQUIRE(std::none_of(v.begin(), v.begin() + k, [&](int x) { return comp(v[k], x); }));
+    REQUIRE(std::none_of(v.begin() + k + 1, v.end(), [&](int x) { return comp(x, v[k]); }));
+}
+
+TEST_CASE( "nth element test", "[nthelement]" ) {
+    SECTION("random and patterns") {
+        for (size_t n : {1, 2, 7, 50, 1000, 20000}) {
+            for (auto& v : MakePatternVectors(n)) {
+                for (size_t k : {size_t(0), n / 4, n / 2, n - 1}) {
+                    CheckNthElement(v, k, std::less<int>());
+                    CheckNthElement(v, k, std::greater<int>());
+                }
+            }
+            CheckNthElement(std::vector<int>(n, 3), n / 2, std::less<int>());
+        }
+    }
+
+    SECTION("nth == last does nothing") {
+        auto v = MakeRandomVector(100, 0, 10);
+        auto original = v;
+        mynth_element(v.begin(), v.end(), v.end(), std::less<int>());
+        REQUIRE(VectorEqual(v, original));
+    }
+
+    SECTION("median of medians select") {
+        for (size_t n : {1, 6, 100, 5001}) {
+            for (auto& v : MakePatternVectors(n)) {
+                auto sorted = v;
+                std::sort(sorted.begin(), sorted.end());
+                auto k = n / 3;
+                medianOfMediansSelect(v.begin(), v.begin() + k, v.end(), std::less<int>());
+                REQUIRE(v[k] == sorted[k]);
+            }
+        }
+    }
+
+    SECTION("adversarial input stays linear") {
+        const size_t n = 1 << 14;
+        AntiQsortState state(n);
+        std::vector<int> v(n);
+        std::iota(v.begin(), v.end(), 0);
+
+        mynth_element(v.begin(), v.begin() + n / 2, v.end(), AntiQsortComp{&state});
+
+        REQUIRE(state.comparisons < 40 * static_cast<long long>(n));
+    }
+}
+
+TEST_CASE( "partial sort test", "[partialsort]" ) {
+    for (size_t n : {0, 1, 2, 50, 1000, 100000}) {
+        for (auto& v : MakePatternVectors(n)) {
+            for (size_t k : {size_t(0), size_t(1), n / 1000, n / 10, n / 2, n}) {
+                if (k > n) {
+                    continue;
+                }
+                auto sorted = v;
+                std::sort(sorted.begin(), sorted.end(), std::greater<int>());
+                auto partial = v;
+                mypartial_sort(partial.begin(), partial.begin() + k, partial.end(), std::greater<int>());
+                REQUIRE(std::equal(partial.begin(), partial.begin() + k, sorted.begin()));
+
+                std::sort(partial.begin(), partial.end(), std::greater<int>());
+                REQUIRE(VectorEqual(partial, sorted));
+            }
+        }
+    }
+
+    SECTION("heap strategy") {
+        auto v = MakeRandomVector(5000, -1000, 1000);
+        auto sorted = v;
+        std::sort(sorted.begin(), sorted.end());
+        heapSelectSort(v.begin(), v.begin() + 10, v.end(), std::less<int>());
+        REQUIRE(std::equal(v.begin(), v.begin() + 10, sorted.begin()));
+    }
+
+    SECTION("top-k of strings") {
+        auto words = MakeRandomStrings(3000, "", 8, 26);
+        auto sorted = words;
+        std::sort(sorted.begin(), sorted.end());
+        mypartial_sort(words.begin(), words.begin() + 100, words.end(), std::less<std::string>());
+        REQUIRE(std::equal(words.begin(), words.begin() + 100, sorted.begin()));
+    }
+}
+
+TEST_CASE( "multi select test", "[multiselect]" ) {
+    SECTION("quantiles") {
+        for (size_t n : {1, 10, 1000, 100000}) {
+            for (auto& v : MakePatternVectors(n)) {
+                std::vector<size_t> ranks = {n / 2, n * 9 / 10, n * 99 / 100, n * 999 / 1000};
+                auto sorted = v;
+                std::sort(sorted.begin(), sorted.end());
+
+                auto values = mymulti_select(v.begin(), v.end(), ranks, std::less<int>());
+                REQUIRE(values.size() == ranks.size());
+                for (size_t i = 0; i < ranks.size(); ++i) {
+                    REQUIRE(values[i] == sorted[ranks[i]]);
+                    REQUIRE(v[ranks[i]] == sorted[ranks[i]]);
+                }
+                // каждая статистика разделяет массив
+                for (auto rank : ranks) {
+                    REQUIRE(std::none_of(v.begin(), v.begin() + rank, [&](int x) { return v[rank] < x; }));
+                    REQUIRE(std::none_of(v.begin() + rank, v.end(), [&](int x) { return x < v[rank]; }));
+                }
+            }
+        }
+    }
+
+    SECTION("many ranks and repeats") {
+        auto v = MakeRandomVector(20000, 0, 500);
+        auto sorted = v;
+        std::sort(sorted.begin(), sorted.end());
+        std::vector<size_t> ranks;
+        for (size_t r = 0; r < v.size(); r += 97) {
+            ranks.push_back(r);
+            ranks.push_back(r);
+        }
+        ranks.push_back(v.size() - 1);
+        auto values = mymulti_select(v.begin(), v.end(), ranks, std::less<int>());
+        for (size_t i = 0; i < ranks.size(); ++i) {
+            REQUIRE(values[i] == sorted[ranks[i]]);
+        }
+
+        auto all = v;
+        std::vector<size_t> everyRank(all.size());
+        std::iota(everyRank.begin(), everyRank.end(), 0);
+        mymulti_select(all.begin(), all.end(), everyRank, std::less<int>());
+        REQUIRE(VectorEqual(all, sorted));
+    }
+
+    SECTION("no ranks") {
+        auto v = MakeRandomVector(100, 0, 10);
+        auto original = v;
+        REQUIRE(mymulti_select(v.begin(), v.end(), {}, std::less<int>()).empty());
+        REQUIRE(VectorEqual(v, original));
+    }
+
+    SECTION("adversarial input stays linear") {
+        const size_t n = 1 << 14;
+        AntiQsortState state(n);
+        std::vector<int> v(n);
+        std::iota(v.begin(), v.end(), 0);
+
+        mymulti_select(v.begin(), v.end(), {n / 2, n * 9 / 10, n * 99 / 100}, AntiQsortComp{&state});
+
+        REQUIRE(state.comparisons < 60 * static_cast<long long>(n));
+    }
+}
+
+/// тип без конструктора по умолчанию: std::stable_sort его принимает
+struct NoDefaultKey {
+    int key;
+    int id;
+
+    NoDefaultKey(int key, int id) : key(key), id(id) {}
+};
+
+std::vector<NoDefaultKey> MakeNoDefaultKeys(size_t n) {
+    std::vector<NoDefaultKey> v;
+    int id = 0;
+    for (int key : MakeRandomVector(n, 0, 100)) {
+        v.emplace_back(key, id++);
+    }
+    return v;
+}
+
+bool NoDefaultKeysStable(const std::vector<NoDefaultKey>& v) {
+    return std::is_sorted(v.begin(), v.end(), [](const NoDefaultKey& a, const NoDefaultKey& b) {
+        return a.key < b.key || (a.key == b.key && a.id < b.id);
+    });
+}
+
+template <typename Comp>
+void CheckStableSort(const std::vector<int>& keys, Comp comp) {
+    // пары (ключ, исходная позиция): устойчивая сортировка не меняет порядок равных ключей
+    std::vector<std::pair<int, int>> v;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        v.push_back({keys[i], static_cast<int>(i)});
+    }
+    auto byKey = [&comp](const std::pair<int, int>& a, const std::pair<int, int>& b) {
+        return comp(a.first, b.first);
+    };
+    auto expected = v;
+    std::stable_sort(expected.begin(), expected.end(), byKey);
+    mystable_sort(v.begin(), v.end(), byKey);
+    REQUIRE(v == expected);
+}
+
+TEST_CASE( "stable sort test", "[stablesort]" ) {
+    SECTION("patterns") {
+        for (size_t n : {0, 1, 2, 31, 32, 33, 100, 1000, 65537}) {
+            for (auto& v : MakePatternVectors(n)) {
+                CheckStableSort(v, std::less<int>());
+                CheckStableSort(v, std::greater<int>());
+            }
+            CheckStableSort(MakeRandomVector(n, 0, 3), std::less<int>());
+        }
+    }
+
+    SECTION("runs that trigger galloping") {
+        std::vector<int> v;
+        for (int block = 0; block < 40; ++block) {
+            for (int i = 0; i < 300; ++i) {
+                v.push_back(block % 2 == 0 ? block * 1000 + i : (39 - block) * 1000 + i);
+            }
+        }
+        CheckStableSort(v, std::less<int>());
+    }
+
+    SECTION("multi-pass sort") {
+        struct Employee {
+            std::string department;
+            int salary;
+        };
+        std::vector<Employee> staff;
+        for (int i = 0; i < 5000; ++i) {
+            staff.push_back({std::string(1, static_cast<char>('a' + rand() % 5)), rand() % 100});
+        }
+        mystable_sort(staff.begin(), staff.end(),
+                      [](const Employee& a, const Employee& b) { return a.salary < b.salary; });
+        mystable_sort(staff.begin(), staff.end(),
+                      [](const Employee& a, const Employee& b) { return a.department < b.department; });
+        REQUIRE(std::is_sorted(staff.begin(), staff.end(), [](const Employee& a, const Employee& b) {
+            return a.department < b.department || (a.department == b.department && a.salary < b.salary);
+        }));
+    }
+
+    SECTION("reusable buffer and move-only values") {
+        std::vector<std::unique_ptr<int>> buffer;
+        for (int round = 0; round < 3; ++round) {
+            std::vector<std::unique_ptr<int>> v;
+            for (int x : MakeRandomVector(3000, 0, 100)) {
+                v.push_back(std::make_unique<int>(x));
+            }
+            mystable_sort(v.begin(), v.end(),
+                          [](const std::unique_ptr<int>& a, const std::unique_ptr<int>& b) { return *a < *b; },
+                          buffer);
+            REQUIRE(std::is_sorted(v.begin(), v.end(),
+                                   [](const std::unique_ptr<int>& a, const std::unique_ptr<int>& b) {
+                                       return *a < *b;
+                                   }));
+            REQUIRE(buffer.size() == v.size());
+        }
+    }
+
+    SECTION("values without default constructor") {
+        auto v = MakeNoDefaultKeys(5000);
+        mystable_sort(v.begin(), v.end(), [](const NoDefaultKey& a, const NoDefaultKey& b) { return a.key < b.key; });
+        REQUIRE(v.size() == 5000);
+        REQUIRE(NoDefaultKeysStable(v));
+    }
+}
+
+TEST_CASE( "in-place stable sort test", "[inplacestable]" ) {
+    SECTION("patterns") {
+        for (size_t n : {0, 1, 2, 100, 256, 257, 1000, 4099, 65537}) {
+            for (auto& v : MakePatternVectors(n)) {
+                CheckStableSort(v, std::less<int>());
+            }
+        }
+    }
+
+    SECTION("enough and scarce unique keys") {
+        for (size_t n : {1000, 20000, 100000}) {
+            for (int distinct : {2, 10, 100, 1000, 1 << 30}) {
+                auto keys = MakeRandomVector(n, 0, distinct - 1);
+                std::vector<std::pair<int, int>> v;
+                for (size_t i = 0; i < keys.size(); ++i) {
+                    v.push_back({keys[i], static_cast<int>(i)});
+                }
+                auto byKey = [](const std::pair<int, int>& a, const std::pair<int, int>& b) {
+                    return a.first < b.first;
+                };
+                auto expected = v;
+                std::stable_sort(expected.begin(), expected.end(), byKey);
+                myinplace_stable_sort(v.begin(), v.end(), byKey);
+                REQUIRE(v == expected);
+            }
+        }
+    }
+
+    SECTION("building blocks") {
+        std::vector<int> v = {5, 1, 5, 2, 1, 7, 2, 9};
+        auto count = collectKeys(v.begin(), v.end(), 10, std::less<int>());
+        REQUIRE(count == 5);
+        REQUIRE(VectorEqual(v, std::vector<int>{1, 2, 5, 7, 9, 5, 1, 2}));
+
+        auto a = MakeRandomVector(300, 0, 50);
+        auto b = MakeRandomVector(500, 0, 50);
+        std::sort(a.begin(), a.end());
+        std::sort(b.begin(), b.end());
+        std::vector<int> merged = a;
+        merged.insert(merged.end(), b.begin(), b.end());
+        auto expected = merged;
+        std::sort(expected.begin(), expected.end());
+        rotationMerge(merged.begin(), merged.begin() + a.size(), merged.end(), std::less<int>());
+        REQUIRE(VectorEqual(merged, expected));
+    }
+
+    SECTION("move-only values") {
+        std::vector<std::unique_ptr<int>> v;
+        for (int x : MakeRandomVector(5000, 0, 100000)) {
+            v.push_back(std::make_unique<int>(x));
+        }
+        auto comp = [](const std::unique_ptr<int>& a, const std::unique_ptr<int>& b) { return *a < *b; };
+        myinplace_stable_sort(v.begin(), v.end(), comp);
+        REQUIRE(std::is_sorted(v.begin(), v.end(), comp));
+    }
+}
+
+TEST_CASE( "timsort test", "[timsort]" ) {
+    SECTION("patterns") {
+        for (size_t n : {0, 1, 2, 31, 32, 33, 100, 1000, 65537}) {
+            for (auto& v : MakePatternVectors(n)) {
+                std::vector<std::pair<int, int>> tagged;
+                for (size_t i = 0; i < v.size(); ++i) {
+                    tagged.push_back({v[i] / 4, static_cast<int>(i)});
+                }
+                auto byKey = [](const std::pair<int, int>& a, const std::pair<int, int>& b) {
+                    return a.first < b.first;
+                };
+                auto expected = tagged;
+                std::stable_sort(expected.begin(), expected.end(), byKey);
+                mytimsort(tagged.begin(), tagged.end(), byKey);
+                REQUIRE(tagged == expected);
+            }
+        }
+    }
+
+    SECTION("concatenated sorted batches") {
+        std::vector<int> v;
+        for (int batch = 0; batch < 50; ++batch) {
+            auto part = MakeRandomVector(static_cast<size_t>(rand() % 5000 + 1), 0, 100000);
+            std::sort(part.begin(), part.end());
+            if (batch % 3 == 0) {
+                std::reverse(part.begin(), part.end());
+            }
+            v.insert(v.end(), part.begin(), part.end());
+        }
+        auto expected = v;
+        std::sort(expected.begin(), expected.end());
+
+        long long comparisons = 0;
+        mytimsort(v.begin(), v.end(), MakeCountingComp(std::less<int>(), &comparisons));
+        REQUIRE(VectorEqual(v, expected));
+        // 50 отрезков: около n log2(50) сравнений, а не n log2(n)
+        REQUIRE(comparisons < 8 * static_cast<long long>(v.size()));
+    }
+
+    SECTION("sorted input is linear") {
+        std::vector<int> v(100000);
+        std::iota(v.begin(), v.end(), 0);
+        long long comparisons = 0;
+        mytimsort(v.begin(), v.end(), MakeCountingComp(std::less<int>(), &comparisons));
+        REQUIRE(comparisons == static_cast<long long>(v.size()) - 1);
+
+        std::reverse(v.begin(), v.end());
+        comparisons = 0;
+        mytimsort(v.begin(), v.end(), MakeCountingComp(std::less<int>(), &comparisons));
+        REQUIRE(comparisons == static_cast<long long>(v.size()) - 1);
+        REQUIRE(std::is_sorted(v.begin(), v.end()));
+    }
+
+    SECTION("min run and power") {
+        REQUIRE(timsortMinRun(63) == 63);
+        REQUIRE(timsortMinRun(64) == 32);
+        REQUIRE(timsortMinRun(65) == 33);
+        REQUIRE(timsortMinRun(1 << 20) == 32);
+        REQUIRE(powersortPower(0, 4, 4, 8) == 1);
+        REQUIRE(powersortPower(0, 2, 2, 8) == 2);
+        REQUIRE(powersortPower(4, 2, 2, 8) == 2);
+    }
+
+    SECTION("values without default constructor") {
+        auto v = MakeNoDefaultKeys(5000);
+        mytimsort(v.begin(), v.end(), [](const NoDefaultKey& a, const NoDefaultKey& b) { return a.key < b.key; });
+        REQUIRE(v.size() == 5000);
+        REQUIRE(NoDefaultKeysStable(v));
+    }
+}
@@ -0,0 +1,316 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/// lock-free дек Чейза-Лева (Correct and Efficient Work-Stealing for Weak Memory Models):
+/// владелец кладет и забирает элементы с нижнего конца, остальные потоки воруют с верхнего.
+/// T должен быть тривиально копируемым (обычно указатель на задачу), capacity - степенью двойки
+template <typename T>
+class WorkStealingDeque {
+public:
+    explicit WorkStealingDeque(std::int64_t capacity = 256) {
+        arrays.emplace_back(new Array(capacity));
+        array.store(arrays.back().get(), std::memory_order_relaxed);
+    }
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    bool empty() const {
+        return bottom.load(std::memory_order_relaxed) <= top.load(std::memory_order_relaxed);
+    }
+
+    /// только для владельца
+    void push(T item) {
+        auto b = bottom.load(std::memory_order_relaxed);
+        auto t = top.load(std::memory_order_acquire);
+        Array* a = array.load(std::memory_order_relaxed);
+        if (b - t > a->capacity - 1) {
+            a = grow(a, b, t);
+        }
+        a->put(b, item);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    /// только для владельца
+    bool pop(T& item) {
+        auto b = bottom.load(std::memory_order_relaxed) - 1;
+        Array* a = array.load(std::memory_order_relaxed);
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto t = top.load(std::memory_order_relaxed);
+        if (t > b) {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+        item = a->get(b);
+        if (t == b) {
+            // последний элемент: соревнуемся с ворами
+            bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    /// для любого потока
+    bool steal(T& item) {
+        auto t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto b = bottom.load(std::memory_order_acquire);
+        if (t >= b) {
+            return false;
+        }
+        Array* a = array.load(std::memory_order_acquire);
+        item = a->get(t);
+        return top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    }
+
+private:
+    struct Array {
+        std::int64_t capacity;
+        std::unique_ptr<std::atomic<T>[]> items;
+
+        explicit Array(std::int64_t capacity) : capacity(capacity), items(new std::atomic<T>[capacity]) {}
+
+        T get(std::int64_t i) const {
+            return items[i & (capacity - 1)].load(std::memory_order_relaxed);
+        }
+
+        void put(std::int64_t i, T item) {
+            items[i & (capacity - 1)].store(item, std::memory_order_relaxed);
+        }
+    };
+
+    /// старые массивы не освобождаются до разрушения дека: вор мог успеть прочитать указатель на них
+    Array* grow(Array* a, std::int64_t b, std::int64_t t) {
+        arrays.emplace_back(new Array(2 * a->capacity));
+        Array* grown = arrays.back().get();
+        for (auto i = t; i < b; ++i) {
+            grown->put(i, a->get(i));
+        }
+        array.store(grown, std::memory_order_release);
+        return grown;
+    }
+
+    alignas(64) std::atomic<std::int64_t> top{0};
+    alignas(64) std::atomic<std::int64_t> bottom{0};
+    std::atomic<Array*> array;
+    std::vector<std::unique_ptr<Array>> arrays;
+};
+
+/// пул потоков с планировщиком work-stealing. потоки создаются один раз и переиспользуются между вызовами.
+/// задача, отправленная из рабочего потока, попадает в его собственный дек; свободные потоки воруют
+/// самые старые (обычно самые крупные) задачи у случайной жертвы. задачи из внешних потоков идут
+/// в общую очередь
+class ThreadPool {
+public:
+    explicit ThreadPool(std::size_t threadCount = std::max(1u, std::thread::hardware_concurrency())) {
+        threadCount = std::max<std::size_t>(threadCount, 1);
+        for (std::size_t i = 0; i < threadCount; ++i) {
+            queues.emplace_back(new WorkStealingDeque<Task*>());
+        }
+        for (std::size_t i = 0; i < threadCount; ++i) {
+            workers.emplace_back([this, i] { workerLoop(i); });
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        condition.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        Task* task;
+        while (takeTask(task, queues.size())) {
+            delete task;
+        }
+    }
+
+    std::size_t size() const {
+        return workers.size();
+    }
+
+    void submit(std::function<void()> task) {
+        Task* item = new Task(std::move(task));
+        // счетчик увеличивается до публикации задачи, чтобы забравший ее поток не увел его ниже нуля
+        ++queuedTasks;
+        auto& context = currentWorker();
+        if (context.pool == this) {
+            queues[context.index]->push(item);
+        } else {
+            std::lock_guard<std::mutex> lock(mutex);
+            injected.push_back(item);
+        }
+        if (sleepers.load() > 0) {
+            std::lock_guard<std::mutex> lock(mutex);
+            condition.notify_one();
+        }
+    }
+
+    /// выполняет одну задачу в вызывающем потоке; false, если задач нет
+    bool runPendingTask() {
+        auto& context = currentWorker();
+        Task* task;
+        if (!takeTask(task, context.pool == this ? context.index : queues.size())) {
+            return false;
+        }
+        run(task);
+        return true;
+    }
+
+private:
+    using Task = std::function<void()>;
+
+    struct WorkerContext {
+        ThreadPool* pool;
+        std::size_t index;
+        std::uint64_t random;
+    };
+
+    static WorkerContext& currentWorker() {
+        static thread_local WorkerContext context{nullptr, 0, 0x9e3779b97f4a7c15ull};
+        return context;
+    }
+
+    /// свой дек (если поток рабочий), затем случайная жертва, затем общая очередь
+    bool takeTask(Task*& task, std::size_t self) {
+        if (self < queues.size() && queues[self]->pop(task)) {
+            --queuedTasks;
+            return true;
+        }
+        if (queuedTasks.load() == 0) {
+            return false;
+        }
+        auto& random = currentWorker().random;
+        random ^= random << 13;
+        random ^= random >> 7;
+        random ^= random << 17;
+        auto start = static_cast<std::size_t>(random % queues.size());
+        for (std::size_t i = 0; i < queues.size(); ++i) {
+            auto victim = (start + i) % queues.size();
+            if (victim != self && queues[victim]->steal(task)) {
+                --queuedTasks;
+                return true;
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        if (injected.empty()) {
+            return false;
+        }
+        task = injected.front();
+        injected.pop_front();
+        --queuedTasks;
+        return true;
+    }
+
+    static void run(Task* task) {
+        std::unique_ptr<Task> owner(task);
+        (*owner)();
+    }
+
+    void workerLoop(std::size_t index) {
+        auto& context = currentWorker();
+        context.pool = this;
+        context.index = index;
+        context.random += index;
+        while (true) {
+            Task* task;
+            if (takeTask(task, index)) {
+                run(task);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(mutex);
+            ++sleepers;
+            condition.wait(lock, [this] { return stop || queuedTasks.load() > 0; });
+            --sleepers;
+            if (stop && queuedTasks.load() == 0) {
+                return;
+            }
+        }
+    }
+
+    std::vector<std::unique_ptr<WorkStealingDeque<Task*>>> queues;
+    std::vector<std::thread> workers;
+    std::deque<Task*> injected;
+    std::atomic<std::size_t> queuedTasks{0};
+    std::atomic<std::size_t> sleepers{0};
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool stop = false;
+};
+
+/// группа задач fork-join: wait() ждет завершения всех запущенных задач, сам выполняя задачи пула,
+/// и пробрасывает первое исключение, брошенное в задаче
+class TaskGroup {
+public:
+    explicit TaskGroup(ThreadPool& pool) : pool(pool) {}
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    ~TaskGroup() {
+        waitAll();
+    }
+
+    template <typename F>
+    void run(F f) {
+        ++pending;
+        pool.submit([this, f] {
+            try {
+                f();
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(exceptionMutex);
+                if (!exception) {
+                    exception = std::current_exception();
+                }
+            }
+            --pending;
+        });
+    }
+
+    void wait() {
+        waitAll();
+        if (exception) {
+            std::rethrow_exception(std::exchange(exception, nullptr));
+        }
+    }
+
+private:
+    void waitAll() {
+        while (pending > 0) {
+            if (!pool.runPendingTask()) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    ThreadPool& pool;
+    std::atomic<std::size_t> pending{0};
+    std::mutex exceptionMutex;
+    std::exception_ptr exception;
+};
+
+inline ThreadPool& defaultThreadPool() {
+    static ThreadPool pool;
+    return pool;
+}